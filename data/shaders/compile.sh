@@ -1,2 +1,8 @@
-/home/user/VulkanSDK/x.x.x.x/x86_64/bin/glslc shader.vert -o vert.spv
-/home/user/VulkanSDK/x.x.x.x/x86_64/bin/glslc shader.frag -o frag.spv
\ No newline at end of file
+#!/bin/sh
+# glslc and spirv-val from the Vulkan SDK (or the distribution's shaderc and spirv-tools packages) on the PATH,
+# run from this directory
+set -e
+for shader in triangle.vert triangle.frag triangle_push.vert cull.comp; do
+  glslc $shader -o $shader.spv
+  spirv-val $shader.spv
+done
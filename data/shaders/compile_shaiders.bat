@@ -1,3 +1,9 @@
 %VULKAN_SDK%\Bin\glslc.exe triangle.vert -o triangle.vert.spv 
+%VULKAN_SDK%\Bin\spirv-val.exe triangle.vert.spv
 %VULKAN_SDK%\Bin\glslc.exe triangle.frag -o triangle.frag.spv
+%VULKAN_SDK%\Bin\spirv-val.exe triangle.frag.spv
+%VULKAN_SDK%\Bin\glslc.exe triangle_push.vert -o triangle_push.vert.spv
+%VULKAN_SDK%\Bin\spirv-val.exe triangle_push.vert.spv
+%VULKAN_SDK%\Bin\glslc.exe cull.comp -o cull.comp.spv
+%VULKAN_SDK%\Bin\spirv-val.exe cull.comp.spv
 pause
\ No newline at end of file
@@ -9,9 +9,13 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec3 inColor;
 
+// per instance
+layout(location = 2) in mat4 inInstanceModel; // locations 2-5
+layout(location = 6) in vec4 inInstanceColor;
+
 layout(location = 0) out vec3 fragColor;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 0.0, 1.0);
-    fragColor = inColor;
+    gl_Position = ubo.proj * ubo.view * inInstanceModel * ubo.model * vec4(inPosition, 0.0, 1.0);
+    fragColor = inColor * inInstanceColor.rgb;
 }
@@ -0,0 +1,27 @@
+#version 450
+
+// push-constant variant of triangle.vert: the per-draw model matrix is pushed,
+// the UBO only carries view/proj, which change on resize at most
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+  mat4 model; // unused here, kept so both variants share one descriptor layout
+  mat4 view;
+  mat4 proj;
+} ubo;
+
+layout(push_constant) uniform PushConstants {
+  mat4 model;
+} push;
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
+// per instance
+layout(location = 2) in mat4 inInstanceModel; // locations 2-5
+layout(location = 6) in vec4 inInstanceColor;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = ubo.proj * ubo.view * inInstanceModel * push.model * vec4(inPosition, 0.0, 1.0);
+    fragColor = inColor * inInstanceColor.rgb;
+}
@@ -13,6 +13,12 @@
 #include "DebugUtilsMessenger.h"
 #include "Settings.hpp"
 #include "QueueFamilies.h"
+#include "SurfaceCache.h"
+#include "Options.h"
+#include "Telemetry.h"
+#include "Timer.hpp"
+#include "JobSystem.h"
+#include "DeviceSelector.h"
 
 #include "EnumerateScheme.hpp"
 
@@ -22,13 +28,32 @@ const bool enableValidationLayers = false;
 const bool enableValidationLayers = true;
 #endif
 
-static std::atomic<bool> swapchainRecreated{ false };
-
 Application::Application(std::string appName)
   : m_window(NULL)
+  , m_instanceVersion(VK_API_VERSION_1_0)
   , m_physicalDevice(VK_NULL_HANDLE)
+  , m_renderPass(VK_NULL_HANDLE)
+  , m_renderPassFormat(VK_FORMAT_UNDEFINED)
+  , m_pipelineLayout(VK_NULL_HANDLE)
+  , m_graphicsPipeline(VK_NULL_HANDLE)
+  , m_usePushConstants(Options::instance().pushConstants())
+  , m_rerecordFrames(m_usePushConstants || Options::instance().rerecordFrames()) // pre-recorded buffers would bake in one model matrix
+  , m_useTimeline(false)
+  , m_graphicsTimeline(VK_NULL_HANDLE)
+  , m_graphicsTimelineValue(0)
   , m_currentFrame(0)
+  , m_frameLag(std::clamp<uint32_t>(Options::instance().frameLag() ? Options::instance().frameLag() : DEFAULT_FRAME_LAG, 1, MAX_FRAMES_IN_FLIGHT))
+  , m_swapchainImageCount(Options::instance().swapchainImages())
+  , m_swapchainImagesInUse(0)
+  , m_presentProfile(Options::instance().presentProfile())
+  , m_presentWaitSupported(false)
+  , m_presentWait(false)
+  , m_vkWaitForPresentKHR(nullptr)
+  , m_presentId(0)
+  , m_lastPresentId(0)
   , m_appName(appName)
+  , m_headless(Options::instance().headless())
+  , m_resizeEpoch(0)
 {
   initWindow();
   initVulkan();
@@ -38,24 +63,36 @@ Application::Application(std::string appName)
 Application::~Application()
 {
   // cleanup
+  discardPendingPipeline();
+  m_pipelineBuilder.finish();
+
   vkDestroyPipeline(m_device, m_graphicsPipeline, nullptr);
   vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
   vkDestroyRenderPass(m_device, m_renderPass, nullptr);
 
+  m_pipelineCache.save();
+  m_pipelineCache.cleanup();
+
   m_swapChain.cleanup();
   m_vertexBuffer.cleanup();
+  m_uploadManager.cleanup();
+  m_memoryAllocator.cleanup();
+  m_gpuTimer.cleanup();
 
   vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
 
   vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
 
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    vkDestroySemaphore(m_device, m_renderFinishedSemaphores[i], nullptr);
-    vkDestroySemaphore(m_device, m_imageAvailableSemaphores[i], nullptr);
-    vkDestroyFence(m_device, m_inFlightFences[i], nullptr);
+  destroySyncObjects();
+  for (const auto semaphore : m_imageAvailableSemaphores) {
+    vkDestroySemaphore(m_device, semaphore, nullptr);
   }
 
   vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+  for (const auto commandPool : m_frameCommandPools) {
+    vkDestroyCommandPool(m_device, commandPool, nullptr);
+  }
+  m_commandRecorder.cleanup();
 
   vkDestroyDevice(m_device, nullptr);
 
@@ -63,9 +100,14 @@ Application::~Application()
     DebugUtilsMessenger::instance().destroy(m_instance, nullptr);
   }
 
+  SurfaceCache::instance().invalidate(m_surface);
   vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
   vkDestroyInstance(m_instance, nullptr);
 
+  if (m_headless) {
+    return;
+  }
+
   glfwDestroyWindow(m_window);
 
   glfwTerminate();
@@ -73,6 +115,10 @@ Application::~Application()
 
 void Application::initWindow() 
 {
+  if (m_headless) {
+    return;
+  }
+
   glfwInit();
 
   glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -86,23 +132,13 @@ void Application::initWindow()
   // store window pointer for use by glfwSetFramebufferSizeCallback
   glfwSetWindowUserPointer(m_window, this);
 
-  // callback function for resize frame
+  // callback function for resize frame -- only publishes the new size, the render worker does the rest
   const auto framebufferResizeCallback = [](GLFWwindow* window, int width, int height) {
     const auto app = static_cast<Application*>(glfwGetWindowUserPointer(window));
     const int iconified = glfwGetWindowAttrib(window, GLFW_ICONIFIED);
     const bool isMinimized { iconified == GLFW_TRUE || !width || !height };
 
-    if (app->pauseWorker() == std::cv_status::timeout || isMinimized) {
-      return;
-    };
-
-    if (swapchainRecreated.load()) { // already recreated from worker
-      swapchainRecreated.store(false);
-      app->resumeWorker();
-      return;
-    }
-    app->recreateSwapChain(width, height);
-    app->resumeWorker();
+    app->m_resizeSignal.publish(isMinimized ? 0 : width, isMinimized ? 0 : height);
   };
   glfwSetFramebufferSizeCallback(m_window, framebufferResizeCallback);
 
@@ -128,33 +164,94 @@ void Application::initVulkan()
   createLogicalDevice();
   createCommandPool();
 
-  m_vertexBuffer.create(m_device, m_physicalDevice, m_graphicsQueue, m_commandPool);
+  m_pipelineCache.create(m_device, m_physicalDevice, Options::instance().pipelineCachePath());
+  m_gpuTimer.create(m_device, m_physicalDevice, QueueFamilies::instance().find(m_physicalDevice, m_surface).graphicsFamily.value(), MAX_FRAMES_IN_FLIGHT);
+
+  // fixed for the run, the pipeline layout and the vertex shader variant depend on it
+  logger << "transforms: " << (m_usePushConstants ? "push constants" : "uniform buffer") << std::endl;
+  logger << "command buffers: " << (m_rerecordFrames ? "re-recorded every frame" : "pre-recorded per frame and image") << std::endl;
+  if (m_rerecordFrames) {
+    createFrameCommandPools();
+  }
+  m_vertexBuffer.setPushConstants(m_usePushConstants);
+
+  if (const uint32_t recordThreads = Options::instance().recordThreads()) {
+    if (m_rerecordFrames) {
+      m_commandRecorder.create(m_device, QueueFamilies::instance().find(m_physicalDevice, m_surface).graphicsFamily.value(), recordThreads, MAX_FRAMES_IN_FLIGHT);
+      logger << "recording: " << recordThreads << " secondary command buffers as jobs on " << JobSystem::instance().workerCount() << " workers" << std::endl;
+    }
+    else {
+      logger << "recording: parallel recording needs re-recorded frames (--rerecord), ignored" << std::endl;
+    }
+  }
+
+  m_memoryAllocator.create(m_device, m_physicalDevice);
+
+  const QueueFamilyIndices indices = QueueFamilies::instance().find(m_physicalDevice, m_surface);
+  const uint32_t uploadFamily = indices.transferFamily.value_or(indices.graphicsFamily.value());
+  logger << "uploads: " << (indices.transferFamily ? "dedicated transfer queue family " : "graphics queue family ") << uploadFamily << std::endl;
+  m_uploadManager.create(m_device, m_memoryAllocator, uploadFamily, indices.graphicsFamily.value(), m_useTimeline);
+
+  m_vertexBuffer.setInstancesPerDraw(Options::instance().instancesPerDraw());
+  if (Options::instance().gpuCulling()) {
+    const bool async = indices.computeFamily && Options::instance().asyncCompute();
+    logger << "culling: " << (async ? "async compute queue family " : "graphics queue family ") << (async ? indices.computeFamily.value() : indices.graphicsFamily.value()) << std::endl;
+    if (async) {
+      m_vertexBuffer.setAsyncCompute(m_computeQueue, indices.computeFamily.value(), indices.graphicsFamily.value());
+    }
+  }
+  m_vertexBuffer.create(m_device, m_physicalDevice, m_memoryAllocator, m_uploadManager, Options::instance().meshPath(), Options::instance().instanceCount());
+  if (Options::instance().gpuCulling()) {
+    m_vertexBuffer.enableCulling(m_pipelineCache.handle());
+  }
+  logger << "draws per frame: " << m_vertexBuffer.drawCount() << (Options::instance().gpuCulling() ? " (indirect, culled on the GPU)" : "") << std::endl;
 
   createDescriptorSetLayout();
+  createPipelineLayout();
   createDescriptorPool();
   createDescriptorSets();
 
-  createCommandBuffers();
+  if (m_useTimeline) {
+    // created once -- swapchain recreation leaves them alone
+    createSyncObjects();
+  }
 }
 
 void Application::initKeyBoard()
 {
+  if (m_headless) {
+    return;
+  }
+
   m_keyBoard.init(m_window);
 }
 
 void Application::run()
 {
+  if (m_headless) {
+    runHeadless();
+    return;
+  }
+
+  int width{ 0 }, height{ 0 };
+  glfwGetFramebufferSize(m_window, &width, &height);
+  m_resizeSignal.publish(width, height);
+  m_resizeEpoch = m_resizeSignal.epoch();
+
   // showWindow
   recreateSwapChain();
   glfwShowWindow(m_window);
 
   std::atomic<bool> keepGoing{ true };
 
-  // render worker
-  auto asyncWorker = std::async(std::launch::async, [this, &keepGoing]() {
+  // render loop, a job that holds one worker until the window closes
+  const JobSystem::Handle renderLoop = JobSystem::instance().submit([this, &keepGoing]() {
     while (keepGoing.load()) {
-      checkWorkerPaused();
+      if (!m_resizeSignal.waitUntilVisible()) {
+        break;
+      }
       try {
+        handleResize();
         drawFrame();
       }
       catch (const VulkanResultException& vkE) {
@@ -175,7 +272,75 @@ void Application::run()
   }
 
   keepGoing.store(false);
+  m_resizeSignal.shutdown();
+  JobSystem::instance().wait(renderLoop);
   vkDeviceWaitIdle(m_device);
+
+  reportStats();
+}
+
+void Application::handleResize()
+{
+  // frame boundary on the render worker -- pick up whatever the window thread published meanwhile
+  ResizeSignal::Request request;
+  if (!m_resizeSignal.consume(m_resizeEpoch, request)) {
+    return;
+  }
+
+  if (request.resized && !m_resizeSince) {
+    m_resizeSince = request.since;
+  }
+
+  recreateSwapChain(request.width, request.height);
+}
+
+void Application::reportStats() const
+{
+  const Telemetry& telemetry = Telemetry::instance();
+  telemetry.report(logger);
+  m_memoryAllocator.report(logger);
+
+  const Options& options = Options::instance();
+  if (!options.statsCsvPath().empty()) {
+    telemetry.exportCsv(options.statsCsvPath());
+  }
+  if (!options.statsJsonPath().empty()) {
+    telemetry.exportJson(options.statsJsonPath());
+  }
+}
+
+void Application::runHeadless()
+{
+  // no window and no events -- drive the real swapchain/present path for a fixed number of frames
+  recreateSwapChain();
+  updateGraphicsPipeline(true); // measure the drawing, not the first pipeline build
+
+  const uint32_t frameCount = Options::instance().frameCount();
+
+  Timer timer;
+  timer.Start();
+
+  try {
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+      drawFrame();
+    }
+  }
+  catch (const VulkanResultException& vkE) {
+    logger << "drawFrame, VkResult exception: "
+      << vkE.file << ":" << vkE.line << ":" << vkE.func << "() " << vkE.source << "() returned " << vkE.result
+      << std::endl;
+    vkDeviceWaitIdle(m_device);
+    throw std::runtime_error("headless run failed!");
+  }
+
+  vkDeviceWaitIdle(m_device);
+  timer.Stop();
+
+  const double seconds = std::chrono::duration<double>(timer.GetElapsed()).count();
+  logger << "headless: " << frameCount << " frames in " << seconds << " s ("
+    << (seconds > 0.0 ? frameCount / seconds : 0.0) << " fps)" << std::endl;
+
+  reportStats();
 }
 
 void Application::setupDebugMessenger()
@@ -193,13 +358,20 @@ void Application::createInstance()
     throw std::runtime_error("validation layers requested, but not available!");
   }
 
+  // vkEnumerateInstanceVersion only exists from 1.1 on; a 1.0 loader rejects any higher apiVersion
+  const auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion");
+  if (enumerateInstanceVersion) {
+    RESULT_HANDLER(enumerateInstanceVersion(&m_instanceVersion), "vkEnumerateInstanceVersion");
+  }
+  m_instanceVersion = std::min(m_instanceVersion, static_cast<uint32_t>(VK_API_VERSION_1_2));
+
   const VkApplicationInfo appInfo {
     .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
     .pApplicationName =  m_appName.c_str(),
     .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
     .pEngineName = "No Engine",
     .engineVersion = VK_MAKE_VERSION(1, 0, 0),
-    .apiVersion = VK_API_VERSION_1_0
+    .apiVersion = m_instanceVersion
   };
 
   VkInstanceCreateInfo createInfo {
@@ -207,7 +379,7 @@ void Application::createInstance()
     .pApplicationInfo = &appInfo
   };
 
-  const std::vector<const char*> extensions{ Tools::instance().getRequiredExtensions(enableValidationLayers) };
+  const std::vector<const char*> extensions{ Tools::instance().getRequiredExtensions(enableValidationLayers, m_headless) };
   createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
   createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -224,9 +396,26 @@ void Application::createInstance()
 
 void Application::createSurface() 
 {
+  if (m_headless) {
+    createHeadlessSurface();
+    return;
+  }
+
   RESULT_HANDLER(glfwCreateWindowSurface(m_instance, m_window, nullptr, &m_surface), "glfwCreateWindowSurface");
 }
 
+void Application::createHeadlessSurface()
+{
+  const auto func = (PFN_vkCreateHeadlessSurfaceEXT)vkGetInstanceProcAddr(m_instance, "vkCreateHeadlessSurfaceEXT");
+  RESULT_HANDLER_EX(func == nullptr, VK_ERROR_EXTENSION_NOT_PRESENT, "vkCreateHeadlessSurfaceEXT");
+
+  static const VkHeadlessSurfaceCreateInfoEXT createInfo {
+    .sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT
+  };
+
+  RESULT_HANDLER(func(m_instance, &createInfo, nullptr, &m_surface), "vkCreateHeadlessSurfaceEXT");
+}
+
 bool Application::isDeviceSuitable(VkPhysicalDevice device) const
 {
   if (!Tools::instance().checkDeviceExtensionSupport(device)) {
@@ -240,21 +429,71 @@ bool Application::isDeviceSuitable(VkPhysicalDevice device) const
   return indices.isComplete() && swapChainAdequate;
 }
 
-void Application::pickPhysicalDevice() 
+bool Application::supportsPresentWait(VkPhysicalDevice device) const
 {
-  const auto devices = enumerate<VkPhysicalDevice>(m_instance);
-  if (devices.empty())
-  {
-    throw std::runtime_error("failed to find GPUs with Vulkan support!");
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(device, &properties);
+
+  if (m_instanceVersion < VK_API_VERSION_1_1 || properties.apiVersion < VK_API_VERSION_1_1) {
+    return false;
   }
 
-  if (const auto iterator = std::find_if(devices.begin(), devices.end(), [&](const auto& device) { return isDeviceSuitable(device); });
-    iterator != devices.end()) {
-    m_physicalDevice = *iterator;
+  const Tools& tools = Tools::instance();
+  if (!tools.isDeviceExtensionSupported(device, VK_KHR_PRESENT_ID_EXTENSION_NAME) ||
+      !tools.isDeviceExtensionSupported(device, VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+    return false;
   }
-  else {
-    throw std::runtime_error("failed to find a suitable GPU!");
+
+  VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR
+  };
+
+  VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+    .pNext = &presentWaitFeatures
+  };
+
+  VkPhysicalDeviceFeatures2 features {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+    .pNext = &presentIdFeatures
+  };
+
+  vkGetPhysicalDeviceFeatures2(device, &features);
+
+  return presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+}
+
+bool Application::supportsTimelineSemaphore(VkPhysicalDevice device) const
+{
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(device, &properties);
+
+  if (m_instanceVersion < VK_API_VERSION_1_2 || properties.apiVersion < VK_API_VERSION_1_2) {
+    return false;
   }
+
+  VkPhysicalDeviceVulkan12Features features12 {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+  };
+
+  VkPhysicalDeviceFeatures2 features {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+    .pNext = &features12
+  };
+
+  vkGetPhysicalDeviceFeatures2(device, &features);
+
+  return features12.timelineSemaphore == VK_TRUE;
+}
+
+void Application::pickPhysicalDevice() 
+{
+  m_physicalDevice = DeviceSelector::pick(
+    m_instance,
+    m_instanceVersion,
+    [this](VkPhysicalDevice device) { return isDeviceSuitable(device); },
+    Options::instance().device()
+  );
 }
 
 void Application::createLogicalDevice() 
@@ -263,6 +502,12 @@ void Application::createLogicalDevice()
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
   std::set<uint32_t> uniqueQueueFamilies { indices.graphicsFamily.value(), indices.presentFamily.value() };
+  if (indices.transferFamily) {
+    uniqueQueueFamilies.insert(indices.transferFamily.value());
+  }
+  if (indices.computeFamily) {
+    uniqueQueueFamilies.insert(indices.computeFamily.value());
+  }
 
   const float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -276,12 +521,52 @@ void Application::createLogicalDevice()
 
   VkPhysicalDeviceFeatures deviceFeatures{};
 
+  m_useTimeline = Options::instance().timelineSemaphores() && supportsTimelineSemaphore(m_physicalDevice);
+  logger << "frame sync: " << (m_useTimeline ? "timeline semaphore" : "fences") << std::endl;
+
+  m_presentWaitSupported = supportsPresentWait(m_physicalDevice);
+  m_presentWait = Options::instance().presentWait() && m_presentWaitSupported;
+  if (Options::instance().presentWait() && !m_presentWaitSupported) {
+    logger << "present wait pacing requested, but VK_KHR_present_wait is not supported" << std::endl;
+  }
+
+  std::vector<const char*> extensions{ deviceExtensions };
+  void* pNext{ nullptr };
+
+  VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+    .presentWait = VK_TRUE
+  };
+
+  VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+    .pNext = &presentWaitFeatures,
+    .presentId = VK_TRUE
+  };
+
+  if (m_presentWaitSupported) {
+    extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+    extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    pNext = &presentIdFeatures;
+  }
+
+  VkPhysicalDeviceVulkan12Features features12 {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+    .pNext = pNext,
+    .timelineSemaphore = VK_TRUE
+  };
+
+  if (m_useTimeline) {
+    pNext = &features12;
+  }
+
   VkDeviceCreateInfo createInfo {
     .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+    .pNext = pNext,
     .queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
     .pQueueCreateInfos = queueCreateInfos.data(),
-    .enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size()),
-    .ppEnabledExtensionNames = deviceExtensions.data(),
+    .enabledExtensionCount = static_cast<uint32_t>(extensions.size()),
+    .ppEnabledExtensionNames = extensions.data(),
     .pEnabledFeatures = &deviceFeatures
   };
 
@@ -294,6 +579,14 @@ void Application::createLogicalDevice()
 
   vkGetDeviceQueue(m_device, indices.graphicsFamily.value(), 0, &m_graphicsQueue);
   vkGetDeviceQueue(m_device, indices.presentFamily.value(), 0, &m_presentQueue);
+  m_computeQueue = VK_NULL_HANDLE;
+  if (indices.computeFamily) {
+    vkGetDeviceQueue(m_device, indices.computeFamily.value(), 0, &m_computeQueue);
+  }
+
+  if (m_presentWaitSupported) {
+    m_vkWaitForPresentKHR = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(m_device, "vkWaitForPresentKHR");
+  }
 }
 
 void Application::createRenderPass() 
@@ -334,7 +627,7 @@ void Application::createDescriptorSetLayout()
 {
   static const VkDescriptorSetLayoutBinding uboLayoutBinding {
     .binding = 0,
-    .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+    .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
     .descriptorCount = 1,
     .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
     .pImmutableSamplers = nullptr,
@@ -363,9 +656,24 @@ VkShaderModule Application::createShaderModule(const std::vector<char> &code) co
   return shaderModule;
 }
 
-void Application::createGraphicsPipeline() 
+void Application::createPipelineLayout()
 {
-  static const std::vector<char> vertShaderCode{ Tools::instance().readFile("shaders/triangle.vert.spv") };
+  const VkPushConstantRange pushConstantRange = VertexBuffer::pushConstantRange();
+
+  const VkPipelineLayoutCreateInfo pipelineLayoutInfo {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+    .setLayoutCount = 1,
+    .pSetLayouts = &m_descriptorSetLayout,
+    .pushConstantRangeCount = m_usePushConstants ? 1u : 0u,
+    .pPushConstantRanges = m_usePushConstants ? &pushConstantRange : nullptr
+  };
+
+  RESULT_HANDLER(vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout), "vkCreatePipelineLayout");
+}
+
+VkPipeline Application::buildGraphicsPipeline(VkRenderPass renderPass) const
+{
+  static const std::vector<char> vertShaderCode{ Tools::instance().readFile(m_usePushConstants ? "shaders/triangle_push.vert.spv" : "shaders/triangle.vert.spv") };
   static const std::vector<char> fragShaderCode{ Tools::instance().readFile("shaders/triangle.frag.spv") };
 
   const VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
@@ -387,12 +695,12 @@ void Application::createGraphicsPipeline()
 
   const VkPipelineShaderStageCreateInfo shaderStages[] { vertShaderStageInfo, fragShaderStageInfo };
 
-  auto bindingDescription = std::move(VertexBuffer::Vertex::getBindingDescription());
-  auto attributeDescriptions = std::move(VertexBuffer::Vertex::getAttributeDescriptions());
+  const auto& bindingDescription = m_vertexBuffer.bindingDescriptions();
+  const auto& attributeDescriptions = m_vertexBuffer.attributeDescriptions();
 
   const VkPipelineVertexInputStateCreateInfo vertexInputInfo {
     .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-    .vertexBindingDescriptionCount = 1,
+    .vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescription.size()),
     .pVertexBindingDescriptions = bindingDescription.data(),
     .vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
     .pVertexAttributeDescriptions = attributeDescriptions.data()
@@ -404,15 +712,19 @@ void Application::createGraphicsPipeline()
     .primitiveRestartEnable = VK_FALSE,
   };
 
-  const VkViewport viewport = m_swapChain.viewport();
-  const VkRect2D scissor = m_swapChain.scissor();
-
-  const VkPipelineViewportStateCreateInfo viewportState {
+  // set at record time, so a resize does not invalidate the pipeline
+  static constexpr VkPipelineViewportStateCreateInfo viewportState {
     .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
     .viewportCount = 1,
-    .pViewports = &viewport,
     .scissorCount = 1,
-    .pScissors = &scissor,
+  };
+
+  static constexpr VkDynamicState dynamicStates[] { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+  static const VkPipelineDynamicStateCreateInfo dynamicState {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+    .dynamicStateCount = static_cast<uint32_t>(std::size(dynamicStates)),
+    .pDynamicStates = dynamicStates
   };
 
   static constexpr VkPipelineRasterizationStateCreateInfo rasterizer {
@@ -446,14 +758,6 @@ void Application::createGraphicsPipeline()
     .blendConstants { 0.0f, 0.0f, 0.0f,  0.0f }
   };
 
-  const VkPipelineLayoutCreateInfo pipelineLayoutInfo {
-    .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-    .setLayoutCount = 1,
-    .pSetLayouts = &m_descriptorSetLayout,
-  };
-
-  RESULT_HANDLER(vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout), "vkCreatePipelineLayout");
-
   const VkGraphicsPipelineCreateInfo pipelineInfo {
     .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
     .stageCount = 2,
@@ -464,15 +768,68 @@ void Application::createGraphicsPipeline()
     .pRasterizationState = &rasterizer,
     .pMultisampleState = &multisampling,
     .pColorBlendState = &colorBlending,
+    .pDynamicState = &dynamicState,
     .layout = m_pipelineLayout,
-    .renderPass = m_renderPass,
+    .renderPass = renderPass,
     .basePipelineHandle = VK_NULL_HANDLE
   };
 
-  RESULT_HANDLER(vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline), "vkCreateGraphicsPipelines");
+  VkPipeline graphicsPipeline{ VK_NULL_HANDLE };
+  const VkResult result = vkCreateGraphicsPipelines(m_device, m_pipelineCache.handle(), 1, &pipelineInfo, nullptr, &graphicsPipeline);
 
   vkDestroyShaderModule(m_device, fragShaderModule, nullptr);
   vkDestroyShaderModule(m_device, vertShaderModule, nullptr);
+
+  RESULT_HANDLER(result, "vkCreateGraphicsPipelines");
+
+  return graphicsPipeline;
+}
+
+void Application::requestGraphicsPipeline()
+{
+  const VkRenderPass renderPass = m_renderPass;
+  m_pendingPipeline = m_pipelineBuilder.build([this, renderPass]() { return buildGraphicsPipeline(renderPass); });
+}
+
+// render thread: swaps in a finished pipeline and re-records the command buffers with it
+void Application::updateGraphicsPipeline(bool wait /* = false */)
+{
+  if (!m_pendingPipeline.valid()) {
+    return;
+  }
+
+  if (!wait && m_pendingPipeline.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    return;
+  }
+  m_pipelineBuilder.finish(); // runs the build on this thread if no worker has picked it up yet
+
+  const VkPipeline graphicsPipeline = m_pendingPipeline.get(); // rethrows a failed build
+
+  // the pre-recorded command buffers may still reference the old pipeline
+  vkDeviceWaitIdle(m_device);
+  vkDestroyPipeline(m_device, m_graphicsPipeline, nullptr);
+  m_graphicsPipeline = graphicsPipeline;
+
+  if (m_swapChain.swapChains()) {
+    vkResetCommandPool(m_device, m_commandPool, 0);
+    recordCommandBuffers();
+  }
+}
+
+// a build still in flight was made against a render pass that is about to go away
+void Application::discardPendingPipeline()
+{
+  if (!m_pendingPipeline.valid()) {
+    return;
+  }
+
+  m_pipelineBuilder.finish();
+  try {
+    vkDestroyPipeline(m_device, m_pendingPipeline.get(), nullptr);
+  }
+  catch (...) {
+    // the build failed, nothing to destroy
+  }
 }
 
 void Application::createCommandPool()
@@ -490,16 +847,43 @@ void Application::createCommandPool()
   RESULT_HANDLER(vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool), "vkCreateCommandPool");
 }
 
+void Application::createFrameCommandPools()
+{
+  const QueueFamilyIndices queueFamilyIndices = QueueFamilies::instance().find(m_physicalDevice, m_surface);
+
+  const VkCommandPoolCreateInfo poolInfo {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+    .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, // reset as a whole every time the frame slot comes around
+    .queueFamilyIndex = queueFamilyIndices.graphicsFamily.value()
+  };
+
+  m_frameCommandPools.resize(MAX_FRAMES_IN_FLIGHT);
+  m_frameCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+
+  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    RESULT_HANDLER(vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_frameCommandPools[i]), "vkCreateCommandPool");
+
+    const VkCommandBufferAllocateInfo allocInfo {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = m_frameCommandPools[i],
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1
+    };
+
+    RESULT_HANDLER(vkAllocateCommandBuffers(m_device, &allocInfo, &m_frameCommandBuffers[i]), "vkAllocateCommandBuffers");
+  }
+}
+
 void Application::createDescriptorPool()
 {
   static const VkDescriptorPoolSize poolSize {
-    .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-    .descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT)
+    .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+    .descriptorCount = 1
   };
 
   static const VkDescriptorPoolCreateInfo poolInfo {
     .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-    .maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT),
+    .maxSets = 1,
     .poolSizeCount = 1,
     .pPoolSizes = &poolSize,
   };
@@ -509,38 +893,46 @@ void Application::createDescriptorPool()
 
 void  Application::createDescriptorSets() 
 {
-  const std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, m_descriptorSetLayout);
-  
   const VkDescriptorSetAllocateInfo allocInfo {
     .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
     .descriptorPool = m_descriptorPool,
-    .descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT), 
-    .pSetLayouts = layouts.data(),
+    .descriptorSetCount = 1,
+    .pSetLayouts = &m_descriptorSetLayout,
   };
 
-  m_descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
-  RESULT_HANDLER(vkAllocateDescriptorSets(m_device, &allocInfo, m_descriptorSets.data()), "vkAllocateDescriptorSets");
+  RESULT_HANDLER(vkAllocateDescriptorSets(m_device, &allocInfo, &m_descriptorSet), "vkAllocateDescriptorSets");
 
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    const VkDescriptorBufferInfo bufferInfo = m_vertexBuffer.descriptorBufferInfo(i);
-
-    const VkWriteDescriptorSet descriptorWrite {
-      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-      .dstSet = m_descriptorSets[i],
-      .dstBinding = 0,
-      .dstArrayElement = 0,
-      .descriptorCount = 1,
-      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-      .pBufferInfo = &bufferInfo,
-    };
+  const VkDescriptorBufferInfo bufferInfo = m_vertexBuffer.descriptorBufferInfo();
 
-    vkUpdateDescriptorSets(m_device, 1, &descriptorWrite, 0, nullptr);
-  }
+  const VkWriteDescriptorSet descriptorWrite {
+    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+    .dstSet = m_descriptorSet,
+    .dstBinding = 0,
+    .dstArrayElement = 0,
+    .descriptorCount = 1,
+    .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+    .pBufferInfo = &bufferInfo,
+  };
+
+  vkUpdateDescriptorSets(m_device, 1, &descriptorWrite, 0, nullptr);
 }
 
 void Application::createCommandBuffers() 
 {
-  m_commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+  if (m_rerecordFrames) {
+    return; // recorded per frame instead, see recordFrameCommandBuffer
+  }
+
+  // recorded per (frame in flight, swapchain image), so the frame lag does not have to match the image count
+  const size_t count = MAX_FRAMES_IN_FLIGHT * std::max<size_t>(m_swapChain.imageCount(), 1);
+  if (m_commandBuffers.size() == count) {
+    return;
+  }
+
+  if (!m_commandBuffers.empty()) {
+    vkFreeCommandBuffers(m_device, m_commandPool, static_cast<uint32_t>(m_commandBuffers.size()), m_commandBuffers.data());
+  }
+  m_commandBuffers.resize(count);
 
   const VkCommandBufferAllocateInfo allocInfo {
     .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
@@ -556,7 +948,26 @@ void Application::createSyncObjects()
 {
   m_imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
   m_renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-  m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+
+  if (m_useTimeline) {
+    static const VkSemaphoreTypeCreateInfo timelineInfo {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+      .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+      .initialValue = 0
+    };
+
+    static const VkSemaphoreCreateInfo timelineSemaphoreInfo {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+      .pNext = &timelineInfo
+    };
+
+    RESULT_HANDLER(vkCreateSemaphore(m_device, &timelineSemaphoreInfo, nullptr, &m_graphicsTimeline), "vkCreateSemaphore");
+    m_graphicsTimelineValue = 0;
+    m_frameTimelineValues.assign(MAX_FRAMES_IN_FLIGHT, 0);
+  }
+  else {
+    m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+  }
 
   static const VkSemaphoreCreateInfo semaphoreInfo {
     .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
@@ -571,16 +982,61 @@ void Application::createSyncObjects()
   for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
     RESULT_HANDLER(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_imageAvailableSemaphores[i]), "vkCreateSemaphore");
     RESULT_HANDLER(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_renderFinishedSemaphores[i]), "vkCreateSemaphore");
-    RESULT_HANDLER(vkCreateFence(m_device, &fenceInfo, nullptr, &m_inFlightFences[i]), "vkCreateFence");
+    if (!m_useTimeline) {
+      RESULT_HANDLER(vkCreateFence(m_device, &fenceInfo, nullptr, &m_inFlightFences[i]), "vkCreateFence");
+    }
+  }
+}
+
+// everything but the image available semaphores, which have to outlive the swapchain that signals them
+void Application::destroySyncObjects()
+{
+  for (const auto semaphore : m_renderFinishedSemaphores) {
+    vkDestroySemaphore(m_device, semaphore, nullptr);
+  }
+  m_renderFinishedSemaphores.clear();
+
+  for (const auto fence : m_inFlightFences) {
+    vkDestroyFence(m_device, fence, nullptr);
+  }
+  m_inFlightFences.clear();
+
+  if (m_graphicsTimeline) {
+    vkDestroySemaphore(m_device, m_graphicsTimeline, nullptr);
+    m_graphicsTimeline = VK_NULL_HANDLE;
   }
 }
 
+void Application::waitForFrame(uint32_t frame)
+{
+  if (m_useTimeline) {
+    const VkSemaphoreWaitInfo waitInfo {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+      .semaphoreCount = 1,
+      .pSemaphores = &m_graphicsTimeline,
+      .pValues = &m_frameTimelineValues[frame]
+    };
+
+    RESULT_HANDLER(vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX), "vkWaitSemaphores");
+    return;
+  }
+
+  RESULT_HANDLER(vkWaitForFences(m_device, 1, &m_inFlightFences[frame], VK_TRUE, UINT64_MAX), "vkWaitForFences");
+  RESULT_HANDLER(vkResetFences(m_device, 1, &m_inFlightFences[frame]), "vkResetFences");
+}
+
 void Application::recreateSwapChain(int width /*= 0*/, int height /*= 0*/)
 {
   int curWidth(width), curHeight(height);
 
-  if (!width || !height) {
-    glfwGetFramebufferSize(m_window, &curWidth, &curHeight);
+  if (m_headless) {
+    curWidth = WIDTH;
+    curHeight = HEIGHT;
+  }
+  else if (!width || !height) {
+    // may run on the render worker, so use the last size published by the window thread
+    curWidth = m_resizeSignal.width();
+    curHeight = m_resizeSignal.height();
   }
 
   const bool isMinimized{ !curWidth || !curHeight };
@@ -588,21 +1044,20 @@ void Application::recreateSwapChain(int width /*= 0*/, int height /*= 0*/)
   const VkSwapchainKHR oldSwapChain = m_swapChain.swapChains();
   m_swapChain.reset();
 
-  std::vector<VkSemaphore> oldImageReadySs = std::move(m_imageAvailableSemaphores);
+  // the timeline path keeps its sync objects across swapchains, the fence path starts over
+  std::vector<VkSemaphore> oldImageReadySs;
+  if (!m_useTimeline) {
+    oldImageReadySs = std::move(m_imageAvailableSemaphores);
+  }
 
   if (oldSwapChain) {
     vkDeviceWaitIdle(m_device);
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-      vkDestroySemaphore(m_device, m_renderFinishedSemaphores[i], nullptr);
-      vkDestroyFence(m_device, m_inFlightFences[i], nullptr);
+    if (!m_useTimeline) {
+      destroySyncObjects();
     }
     // kill imageReadySs later when oldSwapchain is destroyed
 
-    vkDestroyPipeline(m_device, m_graphicsPipeline, nullptr);
-    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
-    vkDestroyRenderPass(m_device, m_renderPass, nullptr);
-
     m_swapChain.killFramebuffers();
     m_swapChain.killSwapchainImageViews();
 
@@ -611,32 +1066,38 @@ void Application::recreateSwapChain(int width /*= 0*/, int height /*= 0*/)
   }
 
   if (isMinimized == false) {
-    m_swapChain.create(m_window, m_device, m_physicalDevice, m_surface, oldSwapChain);
-
-    createRenderPass();
-    createGraphicsPipeline();
+    const VkExtent2D windowExtent { static_cast<uint32_t>(curWidth), static_cast<uint32_t>(curHeight) };
+    m_swapChain.requestImageCount(m_swapchainImageCount.load());
+    m_swapChain.setPresentProfile(m_presentProfile.load());
+    m_swapChain.create(windowExtent, m_device, m_physicalDevice, m_surface, oldSwapChain);
+    m_swapchainImagesInUse.store(m_swapChain.imageCount());
+
+    // viewport and scissor are dynamic, so only a new surface format invalidates these
+    if (m_swapChain.imageFormat() != m_renderPassFormat) {
+      discardPendingPipeline();
+      vkDestroyPipeline(m_device, m_graphicsPipeline, nullptr);
+      m_graphicsPipeline = VK_NULL_HANDLE;
+      vkDestroyRenderPass(m_device, m_renderPass, nullptr);
+
+      createRenderPass();
+      requestGraphicsPipeline(); // frames show the clear color until it is ready
+      m_renderPassFormat = m_swapChain.imageFormat();
+    }
 
     m_swapChain.createFramebuffers(m_renderPass);
 
-    static const VkClearValue clearValues[2] {
-      {.color = { { 0.0f, 0.0f, 0.0f, 1.0f } } },
-      {.depthStencil = { 1.0f, 0 } }
-    };
+    createCommandBuffers();
+    recordCommandBuffers();
 
-    const auto swapchainImages = enumerate<VkImage>(m_device, m_swapChain.swapChains());
-    for (size_t i = 0; i < swapchainImages.size(); ++i) {
-      m_vertexBuffer.renderPass(
-        m_swapChain.renderPassInfo(m_renderPass, i, 2, clearValues),
-        m_commandBuffers[i],// [(i) % MAX_FRAMES_IN_FLIGHT] ,
-        m_graphicsPipeline,
-        m_pipelineLayout,
-        &m_descriptorSets[i]// [(i) % MAX_FRAMES_IN_FLIGHT]
-      );
+    if (!m_useTimeline) {
+      createSyncObjects();
     }
 
-    createSyncObjects();
-
     m_currentFrame = 0;
+
+    // present ids are per swapchain
+    m_presentId = 0;
+    m_lastPresentId = 0;
   }
 
   if (oldSwapChain) {
@@ -648,7 +1109,98 @@ void Application::recreateSwapChain(int width /*= 0*/, int height /*= 0*/)
       vkDestroySemaphore(m_device, semaphore, nullptr);
     }
   }
-  swapchainRecreated.store(!isMinimized);
+}
+
+void Application::recordCommandBuffers()
+{
+  static const VkClearValue clearValues[2] {
+    {.color = { { 0.0f, 0.0f, 0.0f, 1.0f } } },
+    {.depthStencil = { 1.0f, 0 } }
+  };
+
+  if (m_rerecordFrames) {
+    return;
+  }
+
+  const uint32_t imageCount = m_swapChain.imageCount();
+  for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; ++frame) {
+    for (uint32_t image = 0; image < imageCount; ++image) {
+      m_vertexBuffer.renderPass(
+        m_swapChain.renderPassInfo(m_renderPass, image, 2, clearValues),
+        m_commandBuffers[frame * imageCount + image],
+        m_graphicsPipeline,
+        m_pipelineLayout,
+        &m_descriptorSet,
+        m_gpuTimer,
+        frame,
+        0 // each (frame, image) buffer is only resubmitted after its frame slot has completed, no SIMULTANEOUS_USE needed
+      );
+    }
+  }
+}
+
+// the frame slot's previous submission has completed, so its pool can be recycled
+VkCommandBuffer Application::recordFrameCommandBuffer(uint32_t frame, uint32_t imageIndex)
+{
+  static const VkClearValue clearValues[2] {
+    {.color = { { 0.0f, 0.0f, 0.0f, 1.0f } } },
+    {.depthStencil = { 1.0f, 0 } }
+  };
+
+  const ScopedStageTimer stageTimer(Telemetry::Stage::Record);
+
+  RESULT_HANDLER(vkResetCommandPool(m_device, m_frameCommandPools[frame], 0), "vkResetCommandPool");
+
+  const VkRenderPassBeginInfo renderPassInfo = m_swapChain.renderPassInfo(m_renderPass, imageIndex, 2, clearValues);
+
+  // parallel mode: the draw list is split evenly over the recorder's chunks, the primary only executes them
+  std::vector<VkCommandBuffer> secondaries;
+  if (m_commandRecorder.chunkCount() && m_graphicsPipeline != VK_NULL_HANDLE) {
+    const VkCommandBufferInheritanceInfo inheritance {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+      .renderPass = m_renderPass,
+      .subpass = 0,
+      .framebuffer = renderPassInfo.framebuffer
+    };
+
+    const uint64_t drawCount = m_vertexBuffer.drawCount();
+    secondaries = m_commandRecorder.record(frame, inheritance, [&](VkCommandBuffer commandBuffer, uint32_t chunk, uint32_t chunkCount) {
+      const uint32_t firstDraw = static_cast<uint32_t>(drawCount * chunk / chunkCount);
+      const uint32_t lastDraw = static_cast<uint32_t>(drawCount * (chunk + 1) / chunkCount);
+      m_vertexBuffer.recordDraws(commandBuffer, renderPassInfo.renderArea, m_graphicsPipeline, m_pipelineLayout, &m_descriptorSet, frame, firstDraw, lastDraw - firstDraw);
+    });
+  }
+
+  m_vertexBuffer.renderPass(
+    renderPassInfo,
+    m_frameCommandBuffers[frame],
+    m_graphicsPipeline,
+    m_pipelineLayout,
+    &m_descriptorSet,
+    m_gpuTimer,
+    frame,
+    VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    secondaries
+  );
+
+  return m_frameCommandBuffers[frame];
+}
+
+void Application::waitForPreviousPresent()
+{
+  if (!m_presentWait.load() || !m_vkWaitForPresentKHR || !m_lastPresentId) {
+    return;
+  }
+
+  const ScopedStageTimer stageTimer(Telemetry::Stage::PresentWait);
+
+  // bounded, so a hidden or occluded window can't park the render thread forever
+  constexpr uint64_t timeout = 100'000'000; // 100 ms
+  const VkResult result = m_vkWaitForPresentKHR(m_device, m_swapChain.swapChains(), m_lastPresentId, timeout);
+  if (result != VK_SUCCESS && result != VK_TIMEOUT && result != VK_SUBOPTIMAL_KHR) {
+    // out of date or surface lost -- the acquire below deals with it
+    m_lastPresentId = 0;
+  }
 }
 
 void Application::drawFrame()
@@ -656,13 +1208,29 @@ void Application::drawFrame()
   static uint32_t imageIndex(0);
   static VkResult result(VK_SUCCESS);
 
+  const ScopedStageTimer frameTimer(Telemetry::Stage::Frame);
+
   if (m_imageAvailableSemaphores.empty()) {
     recreateSwapChain();
   }
-  // Ensure no more than FRAME_LAG renderings are outstanding
-  RESULT_HANDLER(vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX), "vkWaitForFences");
-  RESULT_HANDLER(vkResetFences(m_device, 1, &m_inFlightFences[m_currentFrame]), "vkResetFences");
-    
+
+  updateGraphicsPipeline();
+
+  // latency mode: no CPU work for the next frame until the previous one is on screen
+  waitForPreviousPresent();
+
+  {
+    const ScopedStageTimer stageTimer(Telemetry::Stage::FenceWait);
+    // Ensure no more than FRAME_LAG renderings are outstanding
+    waitForFrame(m_currentFrame);
+  }
+
+  // the wait above guarantees this slot's previous timestamps have landed
+  if (const auto gpuTime = m_gpuTimer.collect(m_currentFrame)) {
+    Telemetry::instance().record(Telemetry::Stage::GpuFrame, *gpuTime);
+  }
+
+  const auto acquireStart = std::chrono::steady_clock::now();
   do {
     // Get the index of the next available swapchain image:
     result = m_swapChain.acquireNextImageKHR(m_imageAvailableSemaphores[m_currentFrame], &imageIndex);
@@ -674,6 +1242,7 @@ void Application::drawFrame()
       break;
     }
     else if (result == VK_ERROR_SURFACE_LOST_KHR) {
+      SurfaceCache::instance().invalidate(m_surface);
       vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
       createSurface();
       recreateSwapChain();
@@ -682,30 +1251,96 @@ void Application::drawFrame()
       assert(!result);
     }
   } while (result != VK_SUCCESS);
-  
-  m_vertexBuffer.updateUniformBuffer(m_currentFrame, m_swapChain.extent());
+  Telemetry::instance().record(Telemetry::Stage::Acquire, std::chrono::steady_clock::now() - acquireStart);
+
+  {
+    const ScopedStageTimer stageTimer(Telemetry::Stage::UpdateUniform);
+    m_vertexBuffer.beginFrame(m_input);
+    m_vertexBuffer.updateUniformBuffer(m_currentFrame, m_swapChain.extent());
+  }
+
+  {
+    const ScopedStageTimer stageTimer(Telemetry::Stage::Transforms);
+    m_vertexBuffer.updateInstances(m_currentFrame);
+  }
+
+  const VkCommandBuffer commandBuffer = m_rerecordFrames
+    ? recordFrameCommandBuffer(m_currentFrame, imageIndex)
+    : m_commandBuffers[m_currentFrame * m_swapChain.imageCount() + imageIndex];
+
+  // uploads run on the transfer queue: the timeline path waits for the latest batch at vertex input and compute
+  // (an already reached value costs nothing), the fence path waits for it on the CPU
+  if (!m_useTimeline) {
+    m_uploadManager.wait(m_uploadManager.lastTicket());
+  }
+
+  // async culling: the compute queue works on this frame's instances while the graphics queue finishes the previous frame
+  m_vertexBuffer.submitCulling(m_currentFrame);
+
+  VkSemaphore waitSemaphores[3] { m_imageAvailableSemaphores[m_currentFrame] };
+  VkPipelineStageFlags waitStages[3] { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+  uint64_t waitValues[3] { 0 }; // binary ones ignored
+  uint32_t waitCount = 1;
+  if (m_useTimeline) {
+    waitSemaphores[waitCount] = m_uploadManager.timelineSemaphore();
+    waitStages[waitCount] = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    waitValues[waitCount++] = m_uploadManager.lastTicket();
+  }
+  if (const VkSemaphore culled = m_vertexBuffer.cullingSemaphore(m_currentFrame)) {
+    waitSemaphores[waitCount] = culled;
+    waitStages[waitCount++] = GpuCuller::CONSUMER_STAGES; // the stages the acquire barrier starts from
+  }
 
-  const VkSemaphore waitSemaphores[] { m_imageAvailableSemaphores[m_currentFrame] };
   const VkSemaphore signalSemaphores[] { m_renderFinishedSemaphores[m_currentFrame] };
 
-  const VkPipelineStageFlags waitStages[] { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+  // timeline path: binary semaphore for the presentation engine, timeline value for frame completion
+  const uint64_t timelineValue = m_graphicsTimelineValue + 1;
+  const VkSemaphore timelineSignalSemaphores[] { signalSemaphores[0], m_graphicsTimeline };
+  const uint64_t signalValues[] { 0, timelineValue };
+
+  const VkTimelineSemaphoreSubmitInfo timelineInfo {
+    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+    .waitSemaphoreValueCount = waitCount,
+    .pWaitSemaphoreValues = waitValues,
+    .signalSemaphoreValueCount = 2,
+    .pSignalSemaphoreValues = signalValues
+  };
 
   const VkSubmitInfo submitInfo {
     .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-    .waitSemaphoreCount = 1,
+    .pNext = m_useTimeline ? &timelineInfo : nullptr,
+    .waitSemaphoreCount = waitCount,
     .pWaitSemaphores = waitSemaphores,
     .pWaitDstStageMask = waitStages,
     .commandBufferCount = 1,
-    .pCommandBuffers = &m_commandBuffers[m_currentFrame],
-    .signalSemaphoreCount = 1,
-    .pSignalSemaphores = signalSemaphores,
+    .pCommandBuffers = &commandBuffer,
+    .signalSemaphoreCount = m_useTimeline ? 2u : 1u,
+    .pSignalSemaphores = m_useTimeline ? timelineSignalSemaphores : signalSemaphores,
   };
 
-  RESULT_HANDLER(vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_inFlightFences[m_currentFrame]), "vkQueueSubmit");
+  {
+    const ScopedStageTimer stageTimer(Telemetry::Stage::Submit);
+    const VkFence fence = m_useTimeline ? VK_NULL_HANDLE : m_inFlightFences[m_currentFrame];
+    RESULT_HANDLER(vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, fence), "vkQueueSubmit");
+  }
+  if (m_useTimeline) {
+    m_graphicsTimelineValue = timelineValue;
+    m_frameTimelineValues[m_currentFrame] = timelineValue;
+  }
+  m_gpuTimer.submitted(m_currentFrame);
   
   const VkSwapchainKHR swapChains[] { { m_swapChain.swapChains() } };
+
+  const uint64_t presentId = m_presentId + 1;
+  const VkPresentIdKHR presentIdInfo {
+    .sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+    .swapchainCount = 1,
+    .pPresentIds = &presentId
+  };
+
   const VkPresentInfoKHR presentInfo {
     .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+    .pNext = m_vkWaitForPresentKHR ? &presentIdInfo : nullptr,
     .waitSemaphoreCount = 1,
     .pWaitSemaphores = signalSemaphores,
     .swapchainCount = 1,
@@ -713,14 +1348,28 @@ void Application::drawFrame()
     .pImageIndices = &imageIndex,
   };
 
-  result = vkQueuePresentKHR(m_presentQueue, &presentInfo);
+  {
+    const ScopedStageTimer stageTimer(Telemetry::Stage::Present);
+    result = vkQueuePresentKHR(m_presentQueue, &presentInfo);
+  }
+  m_presentId = presentId;
+  if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+    m_lastPresentId = presentId;
+  }
+
+  if (m_resizeSince && (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)) {
+    Telemetry::instance().record(Telemetry::Stage::ResizeToPresent, std::chrono::steady_clock::now() - *m_resizeSince);
+    m_resizeSince.reset();
+  }
   
-  m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+  // the lag may change between frames -- slots past it simply sit idle with their last frame completed
+  m_currentFrame = (m_currentFrame + 1) % m_frameLag.load();
 
   if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
     recreateSwapChain();
   }
   else if (result == VK_ERROR_SURFACE_LOST_KHR) {
+    SurfaceCache::instance().invalidate(m_surface);
     vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
     createSurface();
     recreateSwapChain();
@@ -730,17 +1379,62 @@ void Application::drawFrame()
   }
 }
 
+void Application::adjustFrameLag(int delta)
+{
+  const uint32_t frameLag = static_cast<uint32_t>(std::clamp(static_cast<int>(m_frameLag.load()) + delta, 1, MAX_FRAMES_IN_FLIGHT));
+  m_frameLag.store(frameLag);
+
+  logger << "frame lag: " << frameLag << std::endl;
+}
+
+void Application::adjustSwapchainImages(int delta)
+{
+  const uint32_t current = m_swapchainImageCount.load() ? m_swapchainImageCount.load() : m_swapchainImagesInUse.load();
+  const uint32_t imageCount = static_cast<uint32_t>(std::max(static_cast<int>(current) + delta, 1));
+  m_swapchainImageCount.store(imageCount);
+  m_resizeSignal.requestRecreate();
+
+  logger << "swapchain images requested: " << imageCount << std::endl;
+}
+
+void Application::togglePresentWait()
+{
+  if (!m_presentWaitSupported) {
+    logger << "present wait pacing is not supported on this device" << std::endl;
+    return;
+  }
+
+  m_presentWait = !m_presentWait;
+  logger << "present wait pacing: " << (m_presentWait ? "on" : "off") << std::endl;
+}
+
+void Application::cyclePresentProfile()
+{
+  const uint32_t next = (static_cast<uint32_t>(m_presentProfile.load()) + 1) % static_cast<uint32_t>(PresentProfile::Count);
+  m_presentProfile.store(static_cast<PresentProfile>(next));
+  m_resizeSignal.requestRecreate();
+
+  logger << "present profile requested: " << to_string(static_cast<PresentProfile>(next)) << std::endl;
+}
+
 void Application::rotateRight() 
 {
-  m_vertexBuffer.rotateRight();
+  pushInput(InputEvent::Type::RotateRight);
 }
 
 void Application::rotateLeft() 
 {
-  m_vertexBuffer.rotateLeft();
+  pushInput(InputEvent::Type::RotateLeft);
 }
 
 void Application::rotateToggle() 
 {
-  m_vertexBuffer.rotateToggle();
+  pushInput(InputEvent::Type::RotateToggle);
+}
+
+void Application::pushInput(InputEvent::Type type)
+{
+  if (!m_input.push({ .type = type, .time = std::chrono::steady_clock::now() })) {
+    logger << "input: queue full, event dropped" << std::endl;
+  }
 }
@@ -1,21 +1,27 @@
 #pragma once
 
+#include <future>
+#include <optional>
 #include <vector>
 
 #define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
-#include "Semaphore.hpp"
+#include "ResizeSignal.hpp"
 #include "SwapChain.h"
 #include "KeyBoard.h"
 #include "VertexBuffer.h"
+#include "PipelineCache.h"
+#include "PipelineBuilder.h"
+#include "CommandRecorder.h"
+#include "InputQueue.hpp"
 
 // forward declaration
 struct QueueFamilyIndices;
 struct SwapChainSupportDetails;
 
-class Application : public Semaphore
+class Application
 {
 public:
   Application(std::string appName);
@@ -26,14 +32,26 @@ public:
   void drawFrame();
   void recreateSwapChain(int width = 0, int height = 0);
 
+  // called from the window thread, queued for the render thread
   void rotateRight();
   void rotateLeft();
   void rotateToggle();
 
+  void reportStats() const;
+
+  // runtime latency/throughput controls, called from the window thread
+  void adjustFrameLag(int delta);
+  void adjustSwapchainImages(int delta);
+  void togglePresentWait();
+  void cyclePresentProfile();
+
 private:
   void initWindow();
   void initVulkan();
   void initKeyBoard();
+  void runHeadless();
+  void handleResize();
+  void pushInput(InputEvent::Type type);
 
   void setupDebugMessenger();
   void pickPhysicalDevice();
@@ -41,10 +59,15 @@ private:
 
   void createInstance();
   void createSurface();
+  void createHeadlessSurface();
   void createLogicalDevice();
   void createRenderPass();
   void createDescriptorSetLayout();
-  void createGraphicsPipeline();
+  void createPipelineLayout();
+  VkPipeline buildGraphicsPipeline(VkRenderPass renderPass) const; // runs as a PipelineBuilder job
+  void requestGraphicsPipeline();
+  void updateGraphicsPipeline(bool wait = false);
+  void discardPendingPipeline();
   
   void createDescriptorPool();
   void createDescriptorSets();
@@ -52,6 +75,16 @@ private:
   
   void createCommandBuffers();
   void createSyncObjects();
+  void destroySyncObjects();
+  void waitForFrame(uint32_t frame);
+
+  bool supportsTimelineSemaphore(VkPhysicalDevice device) const;
+  bool supportsPresentWait(VkPhysicalDevice device) const;
+
+  void recordCommandBuffers();
+  void createFrameCommandPools();
+  VkCommandBuffer recordFrameCommandBuffer(uint32_t frame, uint32_t imageIndex);
+  void waitForPreviousPresent();
   
   VkShaderModule createShaderModule(const std::vector<char>& code) const;
 
@@ -59,19 +92,28 @@ private:
   GLFWwindow* m_window;
 
   VkInstance m_instance;
+  uint32_t m_instanceVersion;
   VkSurfaceKHR m_surface;
 
+  MemoryAllocator m_memoryAllocator;
+  UploadManager m_uploadManager;
   VertexBuffer m_vertexBuffer;
   SwapChain m_swapChain;
   KeyBoard m_keyBoard;
+  GpuTimer m_gpuTimer;
+  PipelineCache m_pipelineCache;
+  PipelineBuilder m_pipelineBuilder;
+  std::future<VkPipeline> m_pendingPipeline; // replaces m_graphicsPipeline once built, until then frames are recorded without the draw
     
   VkPhysicalDevice m_physicalDevice;
   VkDevice m_device;
 
   VkQueue m_graphicsQueue;
   VkQueue m_presentQueue;
+  VkQueue m_computeQueue; // compute-only family, VK_NULL_HANDLE when the device has none
 
   VkRenderPass m_renderPass;
+  VkFormat m_renderPassFormat; // render pass and pipeline are only rebuilt when the swapchain format changes
   VkDescriptorSetLayout m_descriptorSetLayout;
   VkPipelineLayout m_pipelineLayout;
   VkPipeline m_graphicsPipeline;
@@ -79,14 +121,47 @@ private:
   VkCommandPool m_commandPool;
   VkDescriptorPool m_descriptorPool;
 
-  std::vector<VkDescriptorSet> m_descriptorSets;
+  VkDescriptorSet m_descriptorSet; // one UNIFORM_BUFFER_DYNAMIC set, frames differ by dynamic offset
+
+  std::vector<VkCommandBuffer> m_commandBuffers; // one per (frame in flight, swapchain image) pair
 
-  std::vector<VkCommandBuffer> m_commandBuffers;
+  bool m_usePushConstants; // per-draw model matrix, selects the vertex shader variant and pipeline layout
+
+  // re-record mode (--rerecord, switched on by push constants): the frame's command buffer is recorded every frame
+  // for the acquired image, from a transient pool per frame in flight that is reset once its frame has completed
+  bool m_rerecordFrames;
+  std::vector<VkCommandPool> m_frameCommandPools;
+  std::vector<VkCommandBuffer> m_frameCommandBuffers;
+  CommandRecorder m_commandRecorder; // parallel recording of the draw list into secondaries, when enabled
 
   std::vector<VkSemaphore> m_imageAvailableSemaphores;
   std::vector<VkSemaphore> m_renderFinishedSemaphores;
   std::vector<VkFence> m_inFlightFences;
 
+  // Vulkan 1.2 path: a single timeline on the graphics queue replaces m_inFlightFences
+  bool m_useTimeline;
+  VkSemaphore m_graphicsTimeline;
+  uint64_t m_graphicsTimelineValue;          // last value signaled by a submit
+  std::vector<uint64_t> m_frameTimelineValues; // value each frame in flight has to reach before reuse
+
   uint32_t m_currentFrame;
+  std::atomic<uint32_t> m_frameLag;          // frames in flight actually used, <= MAX_FRAMES_IN_FLIGHT
+  std::atomic<uint32_t> m_swapchainImageCount; // applied at the next swapchain recreation, 0 = driver minimum + 1
+  std::atomic<uint32_t> m_swapchainImagesInUse;
+  std::atomic<PresentProfile> m_presentProfile; // applied at the next swapchain recreation
+
+  // VK_KHR_present_id + VK_KHR_present_wait pacing
+  bool m_presentWaitSupported;
+  std::atomic<bool> m_presentWait;
+  PFN_vkWaitForPresentKHR m_vkWaitForPresentKHR;
+  uint64_t m_presentId;     // last id handed to vkQueuePresentKHR on the current swapchain
+  uint64_t m_lastPresentId; // last id whose present was actually queued
   std::string m_appName;
+  bool m_headless;
+
+  ResizeSignal m_resizeSignal;
+  uint64_t m_resizeEpoch; // last resize picked up by the render thread
+  std::optional<ResizeSignal::clock::time_point> m_resizeSince; // set until the first present at the new size
+
+  InputQueue m_input; // key presses from the window thread, drained by the render thread every frame
 };
@@ -0,0 +1,95 @@
+#include <algorithm>
+
+#include "CommandRecorder.h"
+#include "JobSystem.h"
+
+#include "ErrorHandling.hpp"
+
+CommandRecorder::CommandRecorder()
+  : m_device{ VK_NULL_HANDLE }
+  , m_chunks{}
+  , m_recorded{}
+{}
+
+CommandRecorder::~CommandRecorder()
+{
+  cleanup();
+}
+
+void CommandRecorder::create(VkDevice device, uint32_t queueFamilyIndex, uint32_t chunkCount, uint32_t frameCount)
+{
+  m_device = device;
+  m_chunks = std::vector<Chunk>(std::max(chunkCount, 1u));
+
+  const VkCommandPoolCreateInfo poolInfo {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+    .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, // reset as a whole every time the frame slot comes around
+    .queueFamilyIndex = queueFamilyIndex
+  };
+
+  for (auto& chunk : m_chunks) {
+    chunk.commandPools.resize(frameCount);
+    chunk.commandBuffers.resize(frameCount);
+
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+      RESULT_HANDLER(vkCreateCommandPool(m_device, &poolInfo, nullptr, &chunk.commandPools[frame]), "vkCreateCommandPool");
+
+      const VkCommandBufferAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = chunk.commandPools[frame],
+        .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+        .commandBufferCount = 1
+      };
+
+      RESULT_HANDLER(vkAllocateCommandBuffers(m_device, &allocInfo, &chunk.commandBuffers[frame]), "vkAllocateCommandBuffers");
+    }
+  }
+}
+
+void CommandRecorder::cleanup()
+{
+  if (!m_device) {
+    return;
+  }
+
+  for (const auto& chunk : m_chunks) {
+    for (const auto commandPool : chunk.commandPools) {
+      vkDestroyCommandPool(m_device, commandPool, nullptr);
+    }
+  }
+
+  m_chunks.clear();
+  m_recorded.clear();
+  m_device = VK_NULL_HANDLE;
+}
+
+uint32_t CommandRecorder::chunkCount() const
+{
+  return static_cast<uint32_t>(m_chunks.size());
+}
+
+const std::vector<VkCommandBuffer>& CommandRecorder::record(uint32_t frame, const VkCommandBufferInheritanceInfo& inheritance, const RecordChunk& recordChunk)
+{
+  JobSystem::instance().parallelFor(chunkCount(), [&](uint32_t index) {
+    const Chunk& chunk = m_chunks[index];
+    const VkCommandBuffer commandBuffer = chunk.commandBuffers[frame];
+
+    RESULT_HANDLER(vkResetCommandPool(m_device, chunk.commandPools[frame], 0), "vkResetCommandPool");
+
+    const VkCommandBufferBeginInfo beginInfo {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+      .pInheritanceInfo = &inheritance
+    };
+
+    RESULT_HANDLER(vkBeginCommandBuffer(commandBuffer, &beginInfo), "vkBeginCommandBuffer");
+    recordChunk(commandBuffer, index, chunkCount());
+    RESULT_HANDLER(vkEndCommandBuffer(commandBuffer), "vkEndCommandBuffer");
+  }); // rethrows a failed chunk
+
+  m_recorded.clear();
+  for (const auto& chunk : m_chunks) {
+    m_recorded.push_back(chunk.commandBuffers[frame]);
+  }
+  return m_recorded;
+}
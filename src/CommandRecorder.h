@@ -0,0 +1,44 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+// Records a frame's draws in parallel into secondary command buffers.
+// Every chunk owns one command pool per frame in flight and is recorded by exactly one JobSystem job at a time, so
+// recording needs no locking; record() runs the chunks as jobs, helps until all are done and returns the
+// secondaries in chunk order for vkCmdExecuteCommands.
+class CommandRecorder
+{
+public:
+  // records chunk `chunk` of `chunkCount` into a secondary that is already begun
+  using RecordChunk = std::function<void(VkCommandBuffer commandBuffer, uint32_t chunk, uint32_t chunkCount)>;
+
+  CommandRecorder();
+  ~CommandRecorder();
+
+  CommandRecorder(const CommandRecorder&) = delete;
+  CommandRecorder& operator= (const CommandRecorder&) = delete;
+
+  void create(VkDevice device, uint32_t queueFamilyIndex, uint32_t chunkCount, uint32_t frameCount);
+  void cleanup();
+
+  uint32_t chunkCount() const;
+
+  // the frame slot's previous submission has to be complete, its pools are reset
+  const std::vector<VkCommandBuffer>& record(uint32_t frame, const VkCommandBufferInheritanceInfo& inheritance, const RecordChunk& recordChunk);
+
+private:
+  struct Chunk
+  {
+    std::vector<VkCommandPool> commandPools;     // per frame in flight
+    std::vector<VkCommandBuffer> commandBuffers; // one secondary per pool
+  };
+
+  VkDevice m_device;
+  std::vector<Chunk> m_chunks;
+  std::vector<VkCommandBuffer> m_recorded; // result of the last record()
+};
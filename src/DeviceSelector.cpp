@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <stdexcept>
+
+#define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "DeviceSelector.h"
+
+#include "EnumerateScheme.hpp"
+
+namespace
+{
+  const char* typeName(VkPhysicalDeviceType type)
+  {
+    switch (type) {
+      case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:   return "discrete";
+      case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+      case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:    return "virtual";
+      case VK_PHYSICAL_DEVICE_TYPE_CPU:            return "cpu";
+      default:                                     return "other";
+    }
+  }
+
+  std::string lowercase(std::string text)
+  {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+  }
+}
+
+VkPhysicalDevice DeviceSelector::pick(
+  VkInstance instance,
+  uint32_t instanceVersion,
+  const std::function<bool(VkPhysicalDevice)>& suitable,
+  const std::string& override
+)
+{
+  const auto devices = enumerate<VkPhysicalDevice>(instance);
+  if (devices.empty()) {
+    throw std::runtime_error("failed to find GPUs with Vulkan support!");
+  }
+
+  std::vector<Candidate> candidates;
+  for (uint32_t index = 0; index < devices.size(); ++index) {
+    Candidate candidate = describe(devices[index], index, instanceVersion);
+    candidate.suitable = suitable(candidate.device);
+    candidate.score = score(candidate);
+    candidates.push_back(candidate);
+  }
+
+  // best first, ties in enumeration order
+  std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+  const Candidate* selected = nullptr;
+  bool anyMatch = false;
+  for (const auto& candidate : candidates) {
+    const bool wanted = override.empty() || matches(candidate, override);
+    anyMatch = anyMatch || wanted;
+    if (wanted && candidate.suitable) {
+      selected = &candidate;
+      break;
+    }
+  }
+
+  logger << "devices (best first):" << std::endl;
+  for (const auto& candidate : candidates) {
+    logger << "  [" << candidate.index << "] " << candidate.properties.deviceName
+      << ", " << typeName(candidate.properties.deviceType)
+      << ", " << (candidate.deviceLocalBytes >> 20) << " MiB device local"
+      << (candidate.asyncCompute ? ", async compute" : "")
+      << (candidate.dedicatedTransfer ? ", transfer queue" : "")
+      << ", score " << candidate.score
+      << (candidate.hasUuid ? ", uuid " + uuidString(candidate) : "")
+      << (candidate.suitable ? "" : " (unsuitable)")
+      << (&candidate == selected ? " <- selected" : "")
+      << std::endl;
+  }
+
+  if (!selected) {
+    if (override.empty()) {
+      throw std::runtime_error("failed to find a suitable GPU!");
+    }
+    throw std::runtime_error(anyMatch
+      ? "device '" + override + "' is not suitable for rendering"
+      : "no device matches '" + override + "', expected an index, part of a name or a UUID");
+  }
+
+  return selected->device;
+}
+
+DeviceSelector::Candidate DeviceSelector::describe(VkPhysicalDevice device, uint32_t index, uint32_t instanceVersion)
+{
+  Candidate candidate{
+    .device = device,
+    .index = index,
+    .properties = {},
+    .uuid = {},
+    .hasUuid = false,
+    .deviceLocalBytes = 0,
+    .asyncCompute = false,
+    .dedicatedTransfer = false,
+    .suitable = false,
+    .score = 0
+  };
+
+  vkGetPhysicalDeviceProperties(device, &candidate.properties);
+
+  if (instanceVersion >= VK_API_VERSION_1_1 && candidate.properties.apiVersion >= VK_API_VERSION_1_1) {
+    VkPhysicalDeviceIDProperties idProperties {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES
+    };
+
+    VkPhysicalDeviceProperties2 properties {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+      .pNext = &idProperties
+    };
+
+    vkGetPhysicalDeviceProperties2(device, &properties);
+    std::copy(std::begin(idProperties.deviceUUID), std::end(idProperties.deviceUUID), candidate.uuid.begin());
+    candidate.hasUuid = true;
+  }
+
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+  for (uint32_t heap = 0; heap < memoryProperties.memoryHeapCount; ++heap) {
+    if (memoryProperties.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+      candidate.deviceLocalBytes = std::max(candidate.deviceLocalBytes, memoryProperties.memoryHeaps[heap].size);
+    }
+  }
+
+  uint32_t queueFamilyCount{ 0 };
+  vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+
+  for (const auto& family : queueFamilies) {
+    const VkQueueFlags flags = family.queueFlags;
+    candidate.asyncCompute = candidate.asyncCompute || ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT));
+    candidate.dedicatedTransfer = candidate.dedicatedTransfer || ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)));
+  }
+
+  return candidate;
+}
+
+// the device type decides; within a type one point per MiB of device-local memory, the extra queue families and the
+// texture size limit count for a few hundred MiB each
+uint64_t DeviceSelector::score(const Candidate& candidate)
+{
+  uint64_t tier = 0;
+  switch (candidate.properties.deviceType) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:   tier = 4; break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: tier = 3; break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:    tier = 2; break;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:            tier = 1; break;
+    default:                                     tier = 0; break;
+  }
+
+  return (tier << 40)
+    + (candidate.deviceLocalBytes >> 20)
+    + (candidate.asyncCompute ? 256 : 0)
+    + (candidate.dedicatedTransfer ? 256 : 0)
+    + candidate.properties.limits.maxImageDimension2D / 64;
+}
+
+// 32 hex digits (dashes ignored): UUID, checked first since one may be all decimal digits;
+// other all-digit strings: enumeration index; anything else: part of the device name
+bool DeviceSelector::matches(const Candidate& candidate, const std::string& override)
+{
+  std::string hex = lowercase(override);
+  hex.erase(std::remove(hex.begin(), hex.end(), '-'), hex.end());
+  if (hex.size() == 2 * VK_UUID_SIZE && std::all_of(hex.begin(), hex.end(), [](unsigned char c) { return std::isxdigit(c); })) {
+    std::string uuid = uuidString(candidate);
+    uuid.erase(std::remove(uuid.begin(), uuid.end(), '-'), uuid.end());
+    return candidate.hasUuid && uuid == hex;
+  }
+
+  if (std::all_of(override.begin(), override.end(), [](unsigned char c) { return std::isdigit(c); })) {
+    try {
+      return std::stoul(override) == candidate.index;
+    }
+    catch (const std::out_of_range&) {
+      return false;
+    }
+  }
+
+  return lowercase(candidate.properties.deviceName).find(lowercase(override)) != std::string::npos;
+}
+
+// 8-4-4-4-12 lowercase hex
+std::string DeviceSelector::uuidString(const Candidate& candidate)
+{
+  std::string result;
+  for (size_t i = 0; i < candidate.uuid.size(); ++i) {
+    char digits[3];
+    std::snprintf(digits, sizeof(digits), "%02x", candidate.uuid[i]);
+    result += digits;
+    if (i == 3 || i == 5 || i == 7 || i == 9) {
+      result += '-';
+    }
+  }
+  return result;
+}
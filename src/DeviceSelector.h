@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Picks the physical device: every device is scored (type first, then device-local memory, limits and queue families),
+// the best suitable one wins and ties keep the enumeration order, so the choice is the same on every run.
+// An override (--device) selects by enumeration index, case-insensitive name substring or UUID instead,
+// e.g. "llvmpipe" to force lavapipe for CPU-only measurements. Holds no state.
+class DeviceSelector final
+{
+public:
+  // logs the ranked list; throws when no device is suitable or the override matches none that is
+  static VkPhysicalDevice pick(
+    VkInstance instance,
+    uint32_t instanceVersion,
+    const std::function<bool(VkPhysicalDevice)>& suitable,
+    const std::string& override
+  );
+
+private:
+  struct Candidate
+  {
+    VkPhysicalDevice device;
+    uint32_t index;                        // in vkEnumeratePhysicalDevices order
+    VkPhysicalDeviceProperties properties;
+    std::array<uint8_t, VK_UUID_SIZE> uuid;
+    bool hasUuid;                          // needs Vulkan 1.1 on both sides
+    VkDeviceSize deviceLocalBytes;         // largest device-local heap
+    bool asyncCompute;                     // compute family without graphics
+    bool dedicatedTransfer;                // transfer family without graphics and compute
+    bool suitable;
+    uint64_t score;
+  };
+
+  static Candidate describe(VkPhysicalDevice device, uint32_t index, uint32_t instanceVersion);
+  static uint64_t score(const Candidate& candidate);
+  static bool matches(const Candidate& candidate, const std::string& override);
+  static std::string uuidString(const Candidate& candidate);
+};
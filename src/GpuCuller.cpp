@@ -0,0 +1,349 @@
+#define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "GpuCuller.h"
+#include "Tools.h"
+
+#include "ErrorHandling.hpp"
+
+namespace
+{
+  constexpr uint32_t WORKGROUP_SIZE = 64; // local_size_x in cull.comp
+}
+
+GpuCuller::GpuCuller()
+  : m_device{ VK_NULL_HANDLE }
+  , m_allocator{ nullptr }
+  , m_descriptorSetLayout{ VK_NULL_HANDLE }
+  , m_pipelineLayout{ VK_NULL_HANDLE }
+  , m_pipeline{ VK_NULL_HANDLE }
+  , m_descriptorPool{ VK_NULL_HANDLE }
+  , m_frames{}
+  , m_computeQueue{ VK_NULL_HANDLE }
+  , m_computeCommandPool{ VK_NULL_HANDLE }
+  , m_handover{ 0, 0 }
+  , m_params{}
+  , m_indexCount{ 0 }
+{}
+
+void GpuCuller::create(
+  VkDevice device,
+  MemoryAllocator& allocator,
+  VkPipelineCache pipelineCache,
+  uint32_t frameCount,
+  const VkDescriptorBufferInfo& uniforms,
+  VkBuffer instances,
+  VkDeviceSize instanceFrameStride,
+  uint32_t instanceCount,
+  VkDeviceSize instanceStride,
+  uint32_t indexCount,
+  float boundingRadius
+)
+{
+  m_device = device;
+  m_allocator = &allocator;
+  m_params = { .radius = boundingRadius, .count = instanceCount };
+  m_indexCount = indexCount;
+
+  m_frames.resize(frameCount);
+  for (auto& frame : m_frames) {
+    frame.computeCommandBuffer = VK_NULL_HANDLE;
+    frame.culled = VK_NULL_HANDLE;
+    frame.visible = createBuffer(instanceStride * instanceCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, frame.visibleMemory);
+    frame.command = createBuffer(sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, frame.commandMemory);
+  }
+
+  createPipeline(pipelineCache);
+  createDescriptorSets(uniforms, instances, instanceFrameStride, instanceStride * instanceCount);
+}
+
+void GpuCuller::cleanup()
+{
+  if (!m_device) {
+    return;
+  }
+
+  for (const auto& frame : m_frames) {
+    vkDestroySemaphore(m_device, frame.culled, nullptr);
+    vkDestroyBuffer(m_device, frame.visible, nullptr);
+    m_allocator->free(frame.visibleMemory);
+    vkDestroyBuffer(m_device, frame.command, nullptr);
+    m_allocator->free(frame.commandMemory);
+  }
+  m_frames.clear();
+
+  vkDestroyCommandPool(m_device, m_computeCommandPool, nullptr); // frees the compute command buffers
+  m_computeCommandPool = VK_NULL_HANDLE;
+  m_computeQueue = VK_NULL_HANDLE;
+  m_handover = QueueOwnershipTransfer{ 0, 0 };
+
+  vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+  vkDestroyPipeline(m_device, m_pipeline, nullptr);
+  vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+  vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+
+  m_device = VK_NULL_HANDLE;
+}
+
+void GpuCuller::useAsyncCompute(VkQueue queue, uint32_t computeFamily, uint32_t graphicsFamily, const std::vector<uint32_t>& uniformOffsets)
+{
+  m_computeQueue = queue;
+  m_handover = QueueOwnershipTransfer{ computeFamily, graphicsFamily };
+
+  const VkCommandPoolCreateInfo poolInfo {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+    .queueFamilyIndex = computeFamily
+  };
+
+  RESULT_HANDLER(vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_computeCommandPool), "vkCreateCommandPool");
+
+  static constexpr VkSemaphoreCreateInfo semaphoreInfo {
+    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+  };
+
+  static constexpr VkCommandBufferBeginInfo beginInfo {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
+  };
+
+  // nothing in the pass changes between frames, so each frame slot's command buffer is recorded once
+  for (uint32_t frame = 0; frame < m_frames.size(); ++frame) {
+    Frame& target = m_frames[frame];
+
+    RESULT_HANDLER(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &target.culled), "vkCreateSemaphore");
+
+    const VkCommandBufferAllocateInfo allocInfo {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = m_computeCommandPool,
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1
+    };
+
+    RESULT_HANDLER(vkAllocateCommandBuffers(m_device, &allocInfo, &target.computeCommandBuffer), "vkAllocateCommandBuffers");
+
+    RESULT_HANDLER(vkBeginCommandBuffer(target.computeCommandBuffer, &beginInfo), "vkBeginCommandBuffer");
+    recordDispatch(target.computeCommandBuffer, frame, uniformOffsets[frame]);
+    m_handover.release(target.computeCommandBuffer, { target.visible, target.command }, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+    RESULT_HANDLER(vkEndCommandBuffer(target.computeCommandBuffer), "vkEndCommandBuffer");
+  }
+}
+
+bool GpuCuller::enabled() const
+{
+  return m_device != VK_NULL_HANDLE;
+}
+
+bool GpuCuller::async() const
+{
+  return m_computeQueue != VK_NULL_HANDLE;
+}
+
+VkBuffer GpuCuller::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, MemoryAllocator::Allocation& memory)
+{
+  const VkBufferCreateInfo bufferInfo {
+    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+    .size = size,
+    .usage = usage,
+    .sharingMode = VK_SHARING_MODE_EXCLUSIVE // async compute hands them over to the graphics family explicitly
+  };
+
+  VkBuffer buffer;
+  RESULT_HANDLER(vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer), "vkCreateBuffer");
+
+  VkMemoryRequirements memRequirements{};
+  vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
+
+  memory = m_allocator->allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  RESULT_HANDLER(vkBindBufferMemory(m_device, buffer, memory.memory, memory.offset), "vkBindBufferMemory");
+
+  return buffer;
+}
+
+void GpuCuller::createPipeline(VkPipelineCache pipelineCache)
+{
+  static const VkDescriptorSetLayoutBinding bindings[] {
+    { .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+    { .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+    { .binding = 2, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT },
+    { .binding = 3, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT }
+  };
+
+  static const VkDescriptorSetLayoutCreateInfo layoutInfo {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+    .bindingCount = 4,
+    .pBindings = bindings
+  };
+
+  RESULT_HANDLER(vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &m_descriptorSetLayout), "vkCreateDescriptorSetLayout");
+
+  static constexpr VkPushConstantRange pushConstantRange {
+    .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+    .offset = 0,
+    .size = sizeof(Params)
+  };
+
+  const VkPipelineLayoutCreateInfo pipelineLayoutInfo {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+    .setLayoutCount = 1,
+    .pSetLayouts = &m_descriptorSetLayout,
+    .pushConstantRangeCount = 1,
+    .pPushConstantRanges = &pushConstantRange
+  };
+
+  RESULT_HANDLER(vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout), "vkCreatePipelineLayout");
+
+  const std::vector<char> code{ Tools::instance().readFile("shaders/cull.comp.spv") };
+
+  const VkShaderModuleCreateInfo moduleInfo {
+    .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+    .codeSize = code.size(),
+    .pCode = reinterpret_cast<const uint32_t*>(code.data())
+  };
+
+  VkShaderModule shaderModule;
+  RESULT_HANDLER(vkCreateShaderModule(m_device, &moduleInfo, nullptr, &shaderModule), "vkCreateShaderModule");
+
+  const VkComputePipelineCreateInfo pipelineInfo {
+    .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+    .stage = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+      .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+      .module = shaderModule,
+      .pName = "main"
+    },
+    .layout = m_pipelineLayout
+  };
+
+  const VkResult result = vkCreateComputePipelines(m_device, pipelineCache, 1, &pipelineInfo, nullptr, &m_pipeline);
+  vkDestroyShaderModule(m_device, shaderModule, nullptr);
+  RESULT_HANDLER(result, "vkCreateComputePipelines");
+}
+
+void GpuCuller::createDescriptorSets(const VkDescriptorBufferInfo& uniforms, VkBuffer instances, VkDeviceSize instanceFrameStride, VkDeviceSize instancesSize)
+{
+  const uint32_t frameCount = static_cast<uint32_t>(m_frames.size());
+
+  const VkDescriptorPoolSize poolSizes[] {
+    { .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, .descriptorCount = frameCount },
+    { .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 3 * frameCount }
+  };
+
+  const VkDescriptorPoolCreateInfo poolInfo {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+    .maxSets = frameCount,
+    .poolSizeCount = 2,
+    .pPoolSizes = poolSizes
+  };
+
+  RESULT_HANDLER(vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_descriptorPool), "vkCreateDescriptorPool");
+
+  for (auto& frame : m_frames) {
+    const VkDescriptorSetAllocateInfo allocInfo {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .descriptorPool = m_descriptorPool,
+      .descriptorSetCount = 1,
+      .pSetLayouts = &m_descriptorSetLayout
+    };
+
+    RESULT_HANDLER(vkAllocateDescriptorSets(m_device, &allocInfo, &frame.descriptorSet), "vkAllocateDescriptorSets");
+
+    const VkDescriptorBufferInfo bufferInfos[] {
+      uniforms,
+      { .buffer = instances, .offset = static_cast<VkDeviceSize>(&frame - m_frames.data()) * instanceFrameStride, .range = instancesSize },
+      { .buffer = frame.visible, .offset = 0, .range = instancesSize },
+      { .buffer = frame.command, .offset = 0, .range = sizeof(VkDrawIndexedIndirectCommand) }
+    };
+
+    VkWriteDescriptorSet writes[4];
+    for (uint32_t binding = 0; binding < 4; ++binding) {
+      writes[binding] = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = frame.descriptorSet,
+        .dstBinding = binding,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pBufferInfo = &bufferInfos[binding]
+      };
+    }
+
+    vkUpdateDescriptorSets(m_device, 4, writes, 0, nullptr);
+  }
+}
+
+void GpuCuller::record(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t uniformOffset) const
+{
+  recordDispatch(commandBuffer, frame, uniformOffset);
+
+  const VkMemoryBarrier cullBarrier {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+    .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+    .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+  };
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCuller::submit(uint32_t frame) const
+{
+  const Frame& target = m_frames[frame];
+
+  const VkSubmitInfo submitInfo {
+    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    .commandBufferCount = 1,
+    .pCommandBuffers = &target.computeCommandBuffer,
+    .signalSemaphoreCount = 1,
+    .pSignalSemaphores = &target.culled
+  };
+
+  RESULT_HANDLER(vkQueueSubmit(m_computeQueue, 1, &submitInfo, VK_NULL_HANDLE), "vkQueueSubmit");
+}
+
+// every submit() releases the buffers, so every graphics submission waiting on it has to acquire them, drawn or not
+void GpuCuller::recordAcquire(VkCommandBuffer commandBuffer, uint32_t frame) const
+{
+  const Frame& target = m_frames[frame];
+  m_handover.acquire(commandBuffer, { target.visible, target.command }, CONSUMER_STAGES, CONSUMER_STAGES, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+}
+
+VkSemaphore GpuCuller::semaphore(uint32_t frame) const
+{
+  return async() ? m_frames[frame].culled : VK_NULL_HANDLE;
+}
+
+void GpuCuller::recordDispatch(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t uniformOffset) const
+{
+  const Frame& target = m_frames[frame];
+
+  // start from an empty draw, the dispatch counts the survivors into instanceCount
+  const VkDrawIndexedIndirectCommand command {
+    .indexCount = m_indexCount,
+    .instanceCount = 0,
+    .firstIndex = 0,
+    .vertexOffset = 0,
+    .firstInstance = 0
+  };
+  vkCmdUpdateBuffer(commandBuffer, target.command, 0, sizeof(command), &command);
+
+  const VkMemoryBarrier resetBarrier {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+    .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+  };
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &resetBarrier, 0, nullptr, 0, nullptr);
+
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &target.descriptorSet, 1, &uniformOffset);
+  vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(m_params), &m_params);
+  vkCmdDispatch(commandBuffer, (m_params.count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+}
+
+VkBuffer GpuCuller::visibleInstances(uint32_t frame) const
+{
+  return m_frames[frame].visible;
+}
+
+VkBuffer GpuCuller::drawCommand(uint32_t frame) const
+{
+  return m_frames[frame].command;
+}
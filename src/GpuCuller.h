@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+
+#include "MemoryAllocator.h"
+#include "QueueOwnership.h"
+
+// Compute pre-pass that frustum culls instance bounding spheres on the GPU.
+// Survivors are compacted into a per-frame visible instance buffer and counted into a VkDrawIndexedIndirectCommand,
+// so drawing N instances costs the CPU one dispatch and one indirect draw regardless of N.
+// With a compute-only queue family the pass runs on its own queue, overlapping the graphics work of the previous frame:
+// a pre-recorded command buffer per frame hands the results over to the graphics family, which acquires them before drawing.
+class GpuCuller
+{
+public:
+  GpuCuller();
+
+  void create(
+    VkDevice device,
+    MemoryAllocator& allocator,
+    VkPipelineCache pipelineCache,
+    uint32_t frameCount,
+    const VkDescriptorBufferInfo& uniforms, // UNIFORM_BUFFER_DYNAMIC, view and proj
+    VkBuffer instances,
+    VkDeviceSize instanceFrameStride, // frame f's instances start at f * instanceFrameStride
+    uint32_t instanceCount,
+    VkDeviceSize instanceStride,
+    uint32_t indexCount,
+    float boundingRadius
+  );
+  void cleanup();
+
+  // after create(); uniformOffsets[frame] is the dynamic offset of the frame's view and proj
+  void useAsyncCompute(VkQueue queue, uint32_t computeFamily, uint32_t graphicsFamily, const std::vector<uint32_t>& uniformOffsets);
+
+  bool enabled() const;
+  bool async() const;
+
+  // same queue: outside a render pass; the frame slot's previous submission has to be complete
+  void record(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t uniformOffset) const;
+
+  // the stages reading the results, where the graphics submission waits on semaphore()
+  static constexpr VkPipelineStageFlags CONSUMER_STAGES = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+
+  // async: submit() the frame's pass once its instances are written, record the acquire into the graphics command buffer
+  // and have its submission wait on semaphore() at CONSUMER_STAGES
+  void submit(uint32_t frame) const;
+  void recordAcquire(VkCommandBuffer commandBuffer, uint32_t frame) const;
+  VkSemaphore semaphore(uint32_t frame) const;
+
+  VkBuffer visibleInstances(uint32_t frame) const;
+  VkBuffer drawCommand(uint32_t frame) const;
+
+private:
+  struct Frame
+  {
+    VkBuffer visible;
+    MemoryAllocator::Allocation visibleMemory;
+    VkBuffer command;
+    MemoryAllocator::Allocation commandMemory;
+    VkDescriptorSet descriptorSet;
+    VkCommandBuffer computeCommandBuffer; // async only
+    VkSemaphore culled;                   // async only, signaled by the compute submission
+  };
+
+  struct Params
+  {
+    float radius;
+    uint32_t count;
+  };
+
+  VkBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, MemoryAllocator::Allocation& memory);
+  void createPipeline(VkPipelineCache pipelineCache);
+  void createDescriptorSets(const VkDescriptorBufferInfo& uniforms, VkBuffer instances, VkDeviceSize instanceFrameStride, VkDeviceSize instancesSize);
+  void recordDispatch(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t uniformOffset) const;
+
+  VkDevice m_device;
+  MemoryAllocator* m_allocator;
+
+  VkDescriptorSetLayout m_descriptorSetLayout;
+  VkPipelineLayout m_pipelineLayout;
+  VkPipeline m_pipeline;
+  VkDescriptorPool m_descriptorPool;
+
+  std::vector<Frame> m_frames;
+
+  VkQueue m_computeQueue;            // VK_NULL_HANDLE: the pass is recorded into the graphics command buffer
+  VkCommandPool m_computeCommandPool;
+  QueueOwnershipTransfer m_handover; // compute family -> graphics family
+
+  Params m_params;
+  uint32_t m_indexCount;
+};
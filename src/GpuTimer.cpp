@@ -0,0 +1,110 @@
+#define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "GpuTimer.h"
+
+#include "ErrorHandling.hpp"
+
+GpuTimer::GpuTimer()
+  : m_device{ VK_NULL_HANDLE }
+  , m_queryPool{ VK_NULL_HANDLE }
+  , m_slotCount{ 0 }
+  , m_timestampPeriod{ 0.0 }
+  , m_timestampMask{ 0 }
+  , m_pending{}
+{}
+
+void GpuTimer::create(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, uint32_t slotCount)
+{
+  m_device = device;
+
+  uint32_t queueFamilyCount{ 0 };
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+  const uint32_t validBits = queueFamilies[queueFamilyIndex].timestampValidBits;
+  if (validBits == 0) {
+    logger << "GpuTimer: queue family " << queueFamilyIndex << " does not support timestamps, GPU timing disabled" << std::endl;
+    return;
+  }
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+  m_timestampPeriod = properties.limits.timestampPeriod;
+  m_timestampMask = validBits >= 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << validBits) - 1;
+  m_slotCount = slotCount;
+  m_pending.assign(slotCount, false);
+
+  const VkQueryPoolCreateInfo createInfo {
+    .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+    .queryType = VK_QUERY_TYPE_TIMESTAMP,
+    .queryCount = 2 * slotCount
+  };
+
+  RESULT_HANDLER(vkCreateQueryPool(m_device, &createInfo, nullptr, &m_queryPool), "vkCreateQueryPool");
+}
+
+void GpuTimer::cleanup()
+{
+  if (m_queryPool) {
+    vkDestroyQueryPool(m_device, m_queryPool, nullptr);
+    m_queryPool = VK_NULL_HANDLE;
+  }
+}
+
+bool GpuTimer::supported() const
+{
+  return m_queryPool != VK_NULL_HANDLE;
+}
+
+void GpuTimer::cmdBegin(VkCommandBuffer commandBuffer, uint32_t slot) const
+{
+  if (!supported() || slot >= m_slotCount) {
+    return;
+  }
+
+  vkCmdResetQueryPool(commandBuffer, m_queryPool, 2 * slot, 2);
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, 2 * slot);
+}
+
+void GpuTimer::cmdEnd(VkCommandBuffer commandBuffer, uint32_t slot) const
+{
+  if (!supported() || slot >= m_slotCount) {
+    return;
+  }
+
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 2 * slot + 1);
+}
+
+void GpuTimer::submitted(uint32_t slot)
+{
+  if (slot < m_slotCount) {
+    m_pending[slot] = true;
+  }
+}
+
+std::optional<std::chrono::nanoseconds> GpuTimer::collect(uint32_t slot)
+{
+  if (!supported() || slot >= m_slotCount || !m_pending[slot]) {
+    return std::nullopt;
+  }
+
+  // { begin, availability, end, availability }
+  uint64_t results[4]{};
+  const VkResult result = vkGetQueryPoolResults(
+    m_device, m_queryPool, 2 * slot, 2, sizeof(results), results, 2 * sizeof(uint64_t),
+    VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+  );
+
+  if (result != VK_SUCCESS || !results[1] || !results[3]) {
+    return std::nullopt; // not there yet, try again next time around the ring
+  }
+  m_pending[slot] = false;
+
+  const uint64_t ticks = ((results[2] & m_timestampMask) - (results[0] & m_timestampMask)) & m_timestampMask;
+  return std::chrono::nanoseconds(static_cast<int64_t>(ticks * m_timestampPeriod));
+}
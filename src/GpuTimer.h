@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+// Ring of timestamp query pairs, one pair per frame in flight.
+// Results are read back only after the frame's fence has signaled, so collect() never stalls.
+class GpuTimer
+{
+public:
+  GpuTimer();
+
+  void create(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, uint32_t slotCount);
+  void cleanup();
+
+  // recorded outside of the render pass, around it
+  void cmdBegin(VkCommandBuffer commandBuffer, uint32_t slot) const;
+  void cmdEnd(VkCommandBuffer commandBuffer, uint32_t slot) const;
+
+  void submitted(uint32_t slot);
+  std::optional<std::chrono::nanoseconds> collect(uint32_t slot);
+
+  bool supported() const;
+
+private:
+  VkDevice m_device;
+  VkQueryPool m_queryPool;
+  uint32_t m_slotCount;
+  double m_timestampPeriod; // nanoseconds per tick
+  uint64_t m_timestampMask;
+  std::vector<bool> m_pending;
+};
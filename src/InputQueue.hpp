@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Input from the window thread, stamped when the callback saw it.
+struct InputEvent
+{
+  enum class Type : uint8_t {
+    RotateRight,
+    RotateLeft,
+    RotateToggle
+  };
+
+  Type type;
+  std::chrono::steady_clock::time_point time;
+};
+
+// Bounded single-producer/single-consumer ring: the window thread pushes, the render thread drains it once per frame.
+// Neither side locks or waits. Both indices only ever grow and are masked on access, and each sits on its own cache line.
+// Each side caches the other's index and reloads it only when the ring looks full or empty.
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+  static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "capacity has to be a power of two");
+
+public:
+  // producer; false when the consumer has fallen a whole ring behind
+  bool push(const T& value)
+  {
+    const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_cachedHead == Capacity) {
+      m_cachedHead = m_head.load(std::memory_order_acquire);
+      if (tail - m_cachedHead == Capacity) {
+        return false;
+      }
+    }
+
+    m_slots[tail & (Capacity - 1)] = value;
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer
+  bool pop(T& value)
+  {
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_cachedTail) {
+      m_cachedTail = m_tail.load(std::memory_order_acquire);
+      if (head == m_cachedTail) {
+        return false;
+      }
+    }
+
+    value = m_slots[head & (Capacity - 1)];
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  static constexpr size_t CACHE_LINE = 64;
+
+  alignas(CACHE_LINE) std::atomic<uint64_t> m_tail{ 0 }; // written by the producer
+  uint64_t m_cachedHead{ 0 };                            // producer's view of m_head
+
+  alignas(CACHE_LINE) std::atomic<uint64_t> m_head{ 0 }; // written by the consumer
+  uint64_t m_cachedTail{ 0 };                            // consumer's view of m_tail
+
+  alignas(CACHE_LINE) std::array<T, Capacity> m_slots{};
+};
+
+using InputQueue = SpscQueue<InputEvent, 256>;
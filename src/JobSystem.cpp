@@ -0,0 +1,257 @@
+#include <algorithm>
+
+#include "JobSystem.h"
+
+namespace
+{
+  constexpr uint32_t NOT_A_WORKER = UINT32_MAX;
+
+  // index of the worker the calling thread is, so that jobs submitted from a job stay on that worker's deque
+  thread_local uint32_t t_worker = NOT_A_WORKER;
+}
+
+JobSystem::JobSystem(typename Singleton<JobSystem>::token)
+  : m_workers{}
+  , m_queues{}
+  , m_nextQueue{ 0 }
+  , m_queued{ 0 }
+  , m_nextGroup{ ANY_GROUP + 1 }
+  , m_waiters{ 0 }
+  , m_scheduled{ 0 }
+  , m_shutdown{ false }
+{
+  const uint32_t workerCount = std::max(std::thread::hardware_concurrency(), 2u);
+
+  for (uint32_t i = 0; i < workerCount; ++i) {
+    m_queues.push_back(std::make_unique<Queue>());
+  }
+  for (uint32_t i = 0; i < workerCount; ++i) {
+    m_workers.emplace_back(&JobSystem::work, this, i);
+  }
+}
+
+JobSystem::~JobSystem()
+{
+  {
+    std::scoped_lock lock(m_sleepMutex);
+    m_shutdown = true;
+  }
+  m_wake.notify_all();
+
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+JobSystem::Handle JobSystem::submit(Job job, std::initializer_list<Handle> dependencies /* = {} */)
+{
+  return submit(std::move(job), dependencies, m_nextGroup.fetch_add(1, std::memory_order_relaxed));
+}
+
+JobSystem::Handle JobSystem::submit(Job job, std::initializer_list<Handle> dependencies, uint64_t group)
+{
+  Handle task = std::make_shared<Task>();
+  task->job = std::move(job);
+  task->group = group;
+
+  for (const Handle& dependency : dependencies) {
+    if (!dependency) {
+      continue;
+    }
+
+    std::scoped_lock lock(dependency->mutex);
+    if (!dependency->finished.load(std::memory_order_relaxed)) {
+      task->blockers.fetch_add(1, std::memory_order_relaxed);
+      dependency->continuations.push_back(task);
+    }
+  }
+
+  // drop submit's own blocker, whoever drops the last one schedules the job
+  if (task->blockers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    schedule(task);
+  }
+  return task;
+}
+
+void JobSystem::wait(const Handle& handle)
+{
+  while (!finished(handle)) {
+    uint64_t scheduled;
+    {
+      std::scoped_lock lock(m_sleepMutex);
+      scheduled = m_scheduled;
+    }
+
+    if (const Handle task = take(handle->group)) {
+      run(task);
+      continue;
+    }
+
+    // nothing of ours queued: sleep until the job finishes or more work shows up, which may be ours
+    std::unique_lock lock(m_sleepMutex);
+    ++m_waiters;
+    m_wake.wait(lock, [&]() { return finished(handle) || m_scheduled != scheduled; });
+    --m_waiters;
+  }
+
+  if (handle->error) {
+    std::rethrow_exception(handle->error);
+  }
+}
+
+bool JobSystem::finished(const Handle& handle)
+{
+  return handle->finished.load(std::memory_order_acquire);
+}
+
+void JobSystem::parallelFor(uint32_t count, const std::function<void(uint32_t index)>& body)
+{
+  if (count == 0) {
+    return;
+  }
+
+  const uint64_t group = m_nextGroup.fetch_add(1, std::memory_order_relaxed);
+
+  std::vector<Handle> jobs;
+  jobs.reserve(count - 1);
+  for (uint32_t index = 1; index < count; ++index) {
+    jobs.push_back(submit([&body, index]() { body(index); }, {}, group));
+  }
+
+  std::exception_ptr error;
+  try {
+    body(0);
+  }
+  catch (...) {
+    error = std::current_exception();
+  }
+
+  // every job has to be done before body goes out of scope, failed or not
+  for (const Handle& job : jobs) {
+    try {
+      wait(job);
+    }
+    catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+// m_queues is complete before the first worker starts, m_workers is still growing while they run
+uint32_t JobSystem::workerCount() const
+{
+  return static_cast<uint32_t>(m_queues.size());
+}
+
+void JobSystem::work(uint32_t index)
+{
+  t_worker = index;
+
+  for (;;) {
+    if (const Handle task = take(ANY_GROUP)) {
+      run(task);
+      continue;
+    }
+
+    std::unique_lock lock(m_sleepMutex);
+    m_wake.wait(lock, [this]() { return m_shutdown || m_queued.load() > 0; });
+    if (m_shutdown && m_queued.load() == 0) {
+      return;
+    }
+  }
+}
+
+void JobSystem::schedule(Handle task)
+{
+  const uint32_t queue = t_worker != NOT_A_WORKER ? t_worker : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % workerCount();
+  m_queued.fetch_add(1);
+  {
+    std::scoped_lock lock(m_queues[queue]->mutex);
+    m_queues[queue]->tasks.push_back(std::move(task));
+  }
+
+  bool waiters;
+  {
+    std::scoped_lock lock(m_sleepMutex); // also keeps the wakeup of a thread about to sleep from getting lost
+    ++m_scheduled;
+    waiters = m_waiters > 0;
+  }
+
+  // a waiter might take the only notification for a job it is not allowed to run
+  if (waiters) {
+    m_wake.notify_all();
+  }
+  else {
+    m_wake.notify_one();
+  }
+}
+
+// newest job of our own deque first (still warm in cache), then the oldest one of somebody else's;
+// waiters skip over jobs of other groups
+JobSystem::Handle JobSystem::take(uint64_t group)
+{
+  const uint32_t count = workerCount();
+  const auto matches = [group](const Handle& task) { return group == ANY_GROUP || task->group == group; };
+
+  if (t_worker != NOT_A_WORKER) {
+    Queue& own = *m_queues[t_worker];
+    std::scoped_lock lock(own.mutex);
+    const auto it = std::find_if(own.tasks.rbegin(), own.tasks.rend(), matches);
+    if (it != own.tasks.rend()) {
+      Handle task = std::move(*it);
+      own.tasks.erase(std::next(it).base());
+      m_queued.fetch_sub(1);
+      return task;
+    }
+  }
+
+  const uint32_t first = t_worker != NOT_A_WORKER ? t_worker + 1 : m_nextQueue.load(std::memory_order_relaxed);
+  for (uint32_t i = 0; i < count; ++i) {
+    Queue& victim = *m_queues[(first + i) % count];
+    std::scoped_lock lock(victim.mutex);
+    const auto it = std::find_if(victim.tasks.begin(), victim.tasks.end(), matches);
+    if (it != victim.tasks.end()) {
+      Handle task = std::move(*it);
+      victim.tasks.erase(it);
+      m_queued.fetch_sub(1);
+      return task;
+    }
+  }
+
+  return nullptr;
+}
+
+void JobSystem::run(const Handle& task)
+{
+  try {
+    task->job();
+  }
+  catch (...) {
+    task->error = std::current_exception();
+  }
+  task->job = nullptr; // release whatever it captured
+
+  std::vector<Handle> ready;
+  {
+    std::scoped_lock lock(task->mutex);
+    task->finished.store(true, std::memory_order_release);
+    ready.swap(task->continuations);
+  }
+
+  for (Handle& continuation : ready) {
+    if (continuation->blockers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      schedule(std::move(continuation));
+    }
+  }
+
+  std::scoped_lock lock(m_sleepMutex);
+  if (m_waiters) {
+    m_wake.notify_all(); // idle workers go back to sleep, the waiter of this job returns
+  }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Singleton.hpp"
+
+// Work-stealing job scheduler shared by every subsystem that wants CPU parallelism.
+// Each worker owns a deque: it pushes and pops its own jobs at the back, idle workers steal from the front of the others.
+// A job starts once all the jobs it depends on have finished. wait() does not block the calling thread while the awaited
+// job's group has queued work -- it runs those jobs itself until the awaited one is done -- so jobs may wait on jobs
+// without starving the pool. Helping stays within the group (the jobs of one parallelFor, otherwise the job alone), so a
+// frame waiting on its own work never ends up running somebody else's long job, such as a pipeline build, inline.
+// Long-running jobs (the render loop) hold a worker for their whole life, hence at least two workers.
+class JobSystem final : public Singleton<JobSystem>
+{
+  struct Task;
+
+public:
+  using Job = std::function<void()>;
+  using Handle = std::shared_ptr<Task>;
+
+  explicit JobSystem(typename Singleton<JobSystem>::token);
+  ~JobSystem();
+
+  // runs job after all dependencies have finished; a failed dependency does not cancel it
+  Handle submit(Job job, std::initializer_list<Handle> dependencies = {});
+
+  // helps with the job's group until the job has finished, rethrows what it threw
+  void wait(const Handle& handle);
+  static bool finished(const Handle& handle);
+
+  // body(0) ... body(count - 1) as jobs, the caller runs its share; rethrows the first failure
+  void parallelFor(uint32_t count, const std::function<void(uint32_t index)>& body);
+
+  uint32_t workerCount() const;
+
+private:
+  struct Task
+  {
+    Job job;
+    uint64_t group{ 0 };                 // waiters only help with jobs of the group they wait on
+    std::atomic<uint32_t> blockers{ 1 }; // unfinished dependencies, +1 while submit() is still wiring them
+    std::mutex mutex;                    // guards continuations and the finished flag's transition
+    std::vector<Handle> continuations;   // jobs waiting on this one
+    std::atomic<bool> finished{ false };
+    std::exception_ptr error;
+  };
+
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Handle> tasks;
+  };
+
+  static constexpr uint64_t ANY_GROUP = 0;
+
+  Handle submit(Job job, std::initializer_list<Handle> dependencies, uint64_t group);
+  void work(uint32_t index);
+  void schedule(Handle task);
+  Handle take(uint64_t group);
+  void run(const Handle& task);
+
+  std::vector<std::thread> m_workers;
+  std::vector<std::unique_ptr<Queue>> m_queues; // one per worker
+  std::atomic<uint32_t> m_nextQueue;            // round robin for jobs submitted from outside the pool
+  std::atomic<uint32_t> m_queued;              // counted before the job is visible, so take() never drops it below zero
+  std::atomic<uint64_t> m_nextGroup;
+
+  // idle workers and waiters sleep here until work is queued or a job finishes
+  std::mutex m_sleepMutex;
+  std::condition_variable m_wake;
+  uint32_t m_waiters;    // threads inside wait(), finishing jobs only wake anyone when there are some
+  uint64_t m_scheduled;  // jobs scheduled so far, waiters look again for work of their group when it changes
+  bool m_shutdown;
+};
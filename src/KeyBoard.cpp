@@ -118,6 +118,48 @@ void KeyBoard::init(GLFWwindow* pWindow)
       return;
     }
 
+    if (key == GLFW_KEY_T && action == GLFW_PRESS)
+    {
+      app->reportStats();
+      return;
+    }
+
+    if (key == GLFW_KEY_LEFT_BRACKET && action == GLFW_PRESS)
+    {
+      app->adjustFrameLag(-1);
+      return;
+    }
+
+    if (key == GLFW_KEY_RIGHT_BRACKET && action == GLFW_PRESS)
+    {
+      app->adjustFrameLag(+1);
+      return;
+    }
+
+    if (key == GLFW_KEY_COMMA && action == GLFW_PRESS)
+    {
+      app->adjustSwapchainImages(-1);
+      return;
+    }
+
+    if (key == GLFW_KEY_PERIOD && action == GLFW_PRESS)
+    {
+      app->adjustSwapchainImages(+1);
+      return;
+    }
+
+    if (key == GLFW_KEY_W && action == GLFW_PRESS)
+    {
+      app->togglePresentWait();
+      return;
+    }
+
+    if (key == GLFW_KEY_P && action == GLFW_PRESS)
+    {
+      app->cyclePresentProfile();
+      return;
+    }
+
   };
   glfwSetKeyCallback(pWindow, keyCallback);
 }
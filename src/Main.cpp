@@ -2,9 +2,12 @@
 #include <stdexcept>
 #include <cstdlib>
 #include "Application.h"
+#include "Options.h"
 
-int main() {
+int main(int argc, char* argv[]) {
   try {
+    Options::instance().parse(argc, argv);
+
     Application app("Vulkan");
     app.run();
   }
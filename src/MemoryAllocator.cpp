@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+#define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "MemoryAllocator.h"
+
+#include "ErrorHandling.hpp"
+
+MemoryAllocator::MemoryAllocator()
+  : m_device{ VK_NULL_HANDLE }
+  , m_memoryProperties{}
+  , m_blockSize{ DEFAULT_BLOCK_SIZE }
+  , m_pools{}
+{}
+
+void MemoryAllocator::create(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize /* = DEFAULT_BLOCK_SIZE */)
+{
+  m_device = device;
+  m_blockSize = blockSize;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+  m_pools.resize(m_memoryProperties.memoryTypeCount);
+}
+
+void MemoryAllocator::cleanup()
+{
+  std::scoped_lock lock(m_mutex);
+
+  for (auto& pool : m_pools) {
+    for (auto& block : pool) {
+      destroyBlock(block);
+    }
+    pool.clear();
+  }
+}
+
+uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+{
+  for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++)
+  {
+    if ((typeFilter & (1 << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+    {
+      return i;
+    }
+  }
+
+  throw std::runtime_error("failed to find suitable memory type!");
+}
+
+// small heaps (e.g. the 256 MiB BAR window) don't get carved into 64 MiB blocks
+VkDeviceSize MemoryAllocator::standardBlockSize(uint32_t memoryType) const
+{
+  const VkDeviceSize heapSize = m_memoryProperties.memoryHeaps[m_memoryProperties.memoryTypes[memoryType].heapIndex].size;
+  return std::min(m_blockSize, heapSize / 8);
+}
+
+MemoryAllocator::Block& MemoryAllocator::createBlock(uint32_t memoryType, VkDeviceSize size, bool oversized)
+{
+  const VkMemoryAllocateInfo allocInfo {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+    .allocationSize = size,
+    .memoryTypeIndex = memoryType
+  };
+
+  Block block {
+    .memory = VK_NULL_HANDLE,
+    .size = size,
+    .mapped = nullptr,
+    .freeRanges = { { 0, size } },
+    .allocationCount = 0,
+    .oversized = oversized
+  };
+
+  RESULT_HANDLER(vkAllocateMemory(m_device, &allocInfo, nullptr, &block.memory), "vkAllocateMemory");
+
+  if (m_memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    RESULT_HANDLER(vkMapMemory(m_device, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped), "vkMapMemory");
+  }
+
+  m_pools[memoryType].push_back(std::move(block));
+  return m_pools[memoryType].back();
+}
+
+void MemoryAllocator::destroyBlock(const Block& block)
+{
+  if (block.mapped) {
+    vkUnmapMemory(m_device, block.memory);
+  }
+  vkFreeMemory(m_device, block.memory, nullptr);
+}
+
+// first fit; alignment padding in front of the allocation stays on the free list
+bool MemoryAllocator::tryAllocate(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+  for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it) {
+    const auto [rangeOffset, rangeSize] = *it;
+    const VkDeviceSize aligned = (rangeOffset + alignment - 1) / alignment * alignment;
+    const VkDeviceSize padding = aligned - rangeOffset;
+
+    if (padding + size > rangeSize) {
+      continue;
+    }
+
+    block.freeRanges.erase(it);
+    if (padding) {
+      block.freeRanges.emplace(rangeOffset, padding);
+    }
+    if (padding + size < rangeSize) {
+      block.freeRanges.emplace(aligned + size, rangeSize - padding - size);
+    }
+
+    ++block.allocationCount;
+    offset = aligned;
+    return true;
+  }
+
+  return false;
+}
+
+MemoryAllocator::Allocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties)
+{
+  const uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+  const VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+
+  std::scoped_lock lock(m_mutex);
+
+  auto& pool = m_pools[memoryType];
+  VkDeviceSize offset{ 0 };
+
+  Block* target{ nullptr };
+  for (auto& block : pool) {
+    if (tryAllocate(block, requirements.size, alignment, offset)) {
+      target = &block;
+      break;
+    }
+  }
+
+  if (!target) {
+    const VkDeviceSize standardSize = standardBlockSize(memoryType);
+    const bool oversized = requirements.size > standardSize;
+
+    target = &createBlock(memoryType, oversized ? requirements.size : standardSize, oversized);
+    tryAllocate(*target, requirements.size, alignment, offset);
+  }
+
+  return {
+    .memory = target->memory,
+    .offset = offset,
+    .size = requirements.size,
+    .mapped = target->mapped ? static_cast<char*>(target->mapped) + offset : nullptr,
+    .memoryType = memoryType
+  };
+}
+
+void MemoryAllocator::free(const Allocation& allocation)
+{
+  if (!allocation.memory) {
+    return;
+  }
+
+  std::scoped_lock lock(m_mutex);
+
+  auto& pool = m_pools[allocation.memoryType];
+  const auto block = std::find_if(pool.begin(), pool.end(), [&](const Block& b) { return b.memory == allocation.memory; });
+  if (block == pool.end()) {
+    return;
+  }
+
+  auto& ranges = block->freeRanges;
+  auto it = ranges.emplace(allocation.offset, allocation.size).first;
+
+  // coalesce with the following and the preceding range
+  const auto next = std::next(it);
+  if (next != ranges.end() && it->first + it->second == next->first) {
+    it->second += next->second;
+    ranges.erase(next);
+  }
+  if (it != ranges.begin()) {
+    const auto prev = std::prev(it);
+    if (prev->first + prev->second == it->first) {
+      prev->second += it->second;
+      ranges.erase(it);
+    }
+  }
+
+  if (--block->allocationCount != 0) {
+    return;
+  }
+
+  // keep at most one empty standard block per memory type around, so a free/allocate cycle does not hit vkAllocateMemory;
+  // oversized blocks would only fit requests like the one they were made for and go right away
+  const bool spareExists = std::any_of(pool.begin(), pool.end(), [&](const Block& b) {
+    return &b != &*block && !b.oversized && b.allocationCount == 0;
+  });
+  if (block->oversized || spareExists) {
+    destroyBlock(*block);
+    pool.erase(block);
+  }
+}
+
+MemoryAllocator::Stats MemoryAllocator::stats() const
+{
+  std::scoped_lock lock(m_mutex);
+
+  Stats stats{ 0, 0, 0, 0 };
+  for (const auto& pool : m_pools) {
+    for (const auto& block : pool) {
+      VkDeviceSize free{ 0 };
+      for (const auto& range : block.freeRanges) {
+        free += range.second;
+      }
+
+      ++stats.blockCount;
+      stats.allocationCount += block.allocationCount;
+      stats.bytesReserved += block.size;
+      stats.bytesUsed += block.size - free;
+    }
+  }
+
+  return stats;
+}
+
+void MemoryAllocator::report(std::ostream& out) const
+{
+  const Stats s = stats();
+  out << "device memory: " << s.allocationCount << " allocations in " << s.blockCount << " blocks, "
+    << std::fixed << std::setprecision(1) << s.bytesUsed / 1024.0 << " KiB used of "
+    << s.bytesReserved / 1024.0 << " KiB reserved" << std::endl;
+}
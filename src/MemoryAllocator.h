@@ -0,0 +1,66 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Sub-allocates buffers out of large VkDeviceMemory blocks, one pool of blocks per memory type.
+// Every block keeps an offset-ordered free list that is coalesced on free; host-visible blocks stay mapped for their lifetime.
+class MemoryAllocator
+{
+public:
+  static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull << 20;
+
+  struct Allocation
+  {
+    VkDeviceMemory memory;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    void* mapped; // nullptr unless the memory type is host visible
+    uint32_t memoryType;
+  };
+
+  struct Stats
+  {
+    uint32_t blockCount;
+    uint32_t allocationCount;
+    VkDeviceSize bytesReserved; // sum of block sizes, i.e. what vkAllocateMemory handed out
+    VkDeviceSize bytesUsed;     // sum of live sub-allocations
+  };
+
+  MemoryAllocator();
+
+  void create(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+  void cleanup();
+
+  Allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties);
+  void free(const Allocation& allocation);
+
+  Stats stats() const;
+  void report(std::ostream& out) const;
+
+private:
+  struct Block
+  {
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    void* mapped;
+    std::map<VkDeviceSize, VkDeviceSize> freeRanges; // offset -> size
+    uint32_t allocationCount;
+    bool oversized; // sized for a single request larger than the standard block
+  };
+
+  uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+  VkDeviceSize standardBlockSize(uint32_t memoryType) const;
+  Block& createBlock(uint32_t memoryType, VkDeviceSize size, bool oversized);
+  void destroyBlock(const Block& block);
+  static bool tryAllocate(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+
+  VkDevice m_device;
+  VkPhysicalDeviceMemoryProperties m_memoryProperties;
+  VkDeviceSize m_blockSize;
+  std::vector<std::vector<Block>> m_pools; // indexed by memory type
+
+  mutable std::mutex m_mutex;
+};
@@ -0,0 +1,174 @@
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MeshFile.h"
+
+MeshFile::MeshFile(const std::string& path)
+  : m_path(path)
+  , m_data(nullptr)
+  , m_size(0)
+#ifdef _WIN32
+  , m_file(INVALID_HANDLE_VALUE)
+  , m_mapping(nullptr)
+#endif
+{
+#ifdef _WIN32
+  m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (m_file == INVALID_HANDLE_VALUE) {
+    throw std::runtime_error("failed to open mesh " + path);
+  }
+
+  LARGE_INTEGER size;
+  GetFileSizeEx(m_file, &size);
+  m_size = static_cast<size_t>(size.QuadPart);
+
+  m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  const void* view = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!view) {
+    if (m_mapping) {
+      CloseHandle(m_mapping);
+    }
+    CloseHandle(m_file);
+    throw std::runtime_error("failed to map mesh " + path);
+  }
+  m_data = static_cast<const std::byte*>(view);
+#else
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("failed to open mesh " + path);
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    throw std::runtime_error("failed to read mesh " + path);
+  }
+  m_size = static_cast<size_t>(st.st_size);
+
+  void* view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping keeps the file alive
+  if (view == MAP_FAILED) {
+    throw std::runtime_error("failed to map mesh " + path);
+  }
+
+  // read front to back once, into staging memory
+  madvise(view, m_size, MADV_SEQUENTIAL);
+  m_data = static_cast<const std::byte*>(view);
+#endif
+
+  try {
+    validate();
+  }
+  catch (...) {
+    unmap();
+    throw;
+  }
+}
+
+MeshFile::~MeshFile()
+{
+  unmap();
+}
+
+void MeshFile::unmap()
+{
+  if (!m_data) {
+    return;
+  }
+
+#ifdef _WIN32
+  UnmapViewOfFile(m_data);
+  CloseHandle(m_mapping);
+  CloseHandle(m_file);
+#else
+  munmap(const_cast<std::byte*>(m_data), m_size);
+#endif
+  m_data = nullptr;
+}
+
+void MeshFile::validate() const
+{
+  using namespace MeshFormat;
+
+  if (m_size < sizeof(Header)) {
+    throw std::runtime_error(m_path + ": too small for a mesh header");
+  }
+
+  const Header& h = header();
+  if (h.magic != MAGIC) {
+    throw std::runtime_error(m_path + ": not a mesh file");
+  }
+  if (h.version != VERSION || h.headerSize < sizeof(Header)) {
+    throw std::runtime_error(m_path + ": unsupported mesh version " + std::to_string(h.version));
+  }
+  if (h.attributeCount > MAX_ATTRIBUTES || (h.indexSize != 2 && h.indexSize != 4) || h.vertexStride == 0) {
+    throw std::runtime_error(m_path + ": corrupt vertex layout");
+  }
+  if (h.vertexCount == 0 || h.indexCount == 0) {
+    throw std::runtime_error(m_path + ": empty mesh"); // zero-sized buffers are invalid in Vulkan
+  }
+  // an index past the vertex blob would have the GPU read out of bounds; the blob itself is not scanned
+  if (h.maxIndex >= h.vertexCount) {
+    throw std::runtime_error(m_path + ": index out of range");
+  }
+  if (!(h.boundingRadius >= 0.0f && h.boundingRadius <= std::numeric_limits<float>::max())) {
+    throw std::runtime_error(m_path + ": corrupt bounding radius"); // negative, infinite or NaN would break culling
+  }
+  if (h.vertexCount > m_size / h.vertexStride || h.indexCount > m_size / h.indexSize) {
+    throw std::runtime_error(m_path + ": blobs out of bounds");
+  }
+  // the pipeline only consumes location 0 (position) and 1 (colour) from the mesh binding,
+  // anything else would alias the per-instance attributes
+  uint32_t locations = 0;
+  for (uint32_t i = 0; i < h.attributeCount; ++i) {
+    const VertexAttribute& attribute = h.attributes[i];
+    if (attribute.location > 1 || (locations & (1u << attribute.location))
+      || attribute.format < AttributeFormat::Float2 || attribute.format > AttributeFormat::Float4
+      || uint64_t{ attribute.offset } + attributeSize(attribute.format) > h.vertexStride) {
+      throw std::runtime_error(m_path + ": corrupt vertex layout");
+    }
+    locations |= 1u << attribute.location;
+  }
+  if (h.vertexOffset % BLOB_ALIGNMENT || h.indexOffset % BLOB_ALIGNMENT
+    || h.vertexOffset < h.headerSize || h.vertexOffset > m_size || h.indexOffset > m_size
+    || h.vertexOffset + vertexDataSize() > h.indexOffset
+    || h.indexOffset + indexDataSize() > m_size) {
+    throw std::runtime_error(m_path + ": blobs out of bounds");
+  }
+}
+
+const MeshFormat::Header& MeshFile::header() const
+{
+  return *reinterpret_cast<const MeshFormat::Header*>(m_data);
+}
+
+const void* MeshFile::vertexData() const
+{
+  return m_data + header().vertexOffset;
+}
+
+size_t MeshFile::vertexDataSize() const
+{
+  return static_cast<size_t>(header().vertexCount * header().vertexStride);
+}
+
+const void* MeshFile::indexData() const
+{
+  return m_data + header().indexOffset;
+}
+
+size_t MeshFile::indexDataSize() const
+{
+  return static_cast<size_t>(header().indexCount * header().indexSize);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "MeshFormat.hpp"
+
+// Read-only memory mapping of a MeshFormat file. Nothing is parsed or copied: the header is validated
+// and the blobs are handed out as pointers into the mapping, valid for the lifetime of the object.
+class MeshFile
+{
+public:
+  explicit MeshFile(const std::string& path);
+  ~MeshFile();
+
+  MeshFile(const MeshFile&) = delete;
+  MeshFile& operator= (const MeshFile&) = delete;
+
+  const MeshFormat::Header& header() const;
+
+  const void* vertexData() const;
+  size_t vertexDataSize() const;
+
+  const void* indexData() const;
+  size_t indexDataSize() const;
+
+private:
+  void validate() const;
+  void unmap();
+
+  std::string m_path;
+  const std::byte* m_data;
+  size_t m_size;
+#ifdef _WIN32
+  void* m_file;
+  void* m_mapping;
+#endif
+};
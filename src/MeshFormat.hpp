@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+// On-disk mesh container, shared by the runtime loader (MeshFile) and tools/mesh_convert.
+//
+//   Header | vertex blob | index blob
+//
+// Both blobs start at a multiple of BLOB_ALIGNMENT from the beginning of the file, so a mapped file can be
+// copied into staging memory as is. All fields are little endian.
+namespace MeshFormat
+{
+  constexpr uint32_t MAGIC = 0x48534D56; // "VMSH"
+  constexpr uint32_t VERSION = 3; // 2: maxIndex, 3: boundingRadius
+  constexpr uint64_t BLOB_ALIGNMENT = 256;
+  constexpr uint32_t MAX_ATTRIBUTES = 8;
+
+  enum class AttributeFormat : uint32_t
+  {
+    Float2 = 1,
+    Float3 = 2,
+    Float4 = 3
+  };
+
+  struct VertexAttribute
+  {
+    uint32_t location;
+    AttributeFormat format;
+    uint32_t offset; // within the vertex
+    uint32_t reserved;
+  };
+
+  struct Header
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize; // sizeof(Header), lets later versions append fields
+    uint32_t vertexStride;
+    uint32_t attributeCount;
+    uint32_t indexSize;  // 2 or 4 bytes
+    VertexAttribute attributes[MAX_ATTRIBUTES];
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint32_t maxIndex;   // largest index in the index blob, range checked by the converter so loading never scans it
+    float boundingRadius; // largest xy distance of a position from the origin, the culling sphere
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+  };
+
+  static_assert(sizeof(Header) == 192, "MeshFormat::Header is part of the file format");
+
+  constexpr uint32_t attributeSize(AttributeFormat format)
+  {
+    switch (format) {
+      case AttributeFormat::Float2: return 2 * sizeof(float);
+      case AttributeFormat::Float3: return 3 * sizeof(float);
+      case AttributeFormat::Float4: return 4 * sizeof(float);
+    }
+    return 0;
+  }
+
+  constexpr uint64_t alignBlob(uint64_t offset)
+  {
+    return (offset + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+  }
+}
@@ -0,0 +1,191 @@
+#include <cstdlib>
+#include <stdexcept>
+
+#include "Options.h"
+
+uint32_t Options::toUint(const std::string& name, const std::string& value)
+{
+  try {
+    return static_cast<uint32_t>(std::stoul(value));
+  }
+  catch (const std::exception&) {
+    throw std::runtime_error("invalid value '" + value + "' for " + name);
+  }
+}
+
+uint32_t Options::toPositiveUint(const std::string& name, const std::string& value)
+{
+  const uint32_t result = toUint(name, value);
+  if (result == 0) {
+    throw std::runtime_error("invalid value '" + value + "' for " + name + ", expected at least 1");
+  }
+  return result;
+}
+
+PresentProfile Options::toPresentProfile(const std::string& name, const std::string& value)
+{
+  if (const auto profile = parsePresentProfile(value)) {
+    return *profile;
+  }
+
+  throw std::runtime_error("invalid value '" + value + "' for " + name + ", expected low-latency, vsync, power-save or uncapped");
+}
+
+void Options::parseEnvironment()
+{
+  if (const char* headless = std::getenv("VULKANTEST_HEADLESS")) {
+    m_headless = std::string(headless) != "0";
+  }
+
+  if (const char* frames = std::getenv("VULKANTEST_FRAMES")) {
+    m_frameCount = toUint("VULKANTEST_FRAMES", frames);
+  }
+
+  if (const char* timeline = std::getenv("VULKANTEST_TIMELINE")) {
+    m_timelineSemaphores = std::string(timeline) != "0";
+  }
+
+  if (const char* lag = std::getenv("VULKANTEST_FRAME_LAG")) {
+    m_frameLag = toUint("VULKANTEST_FRAME_LAG", lag);
+  }
+
+  if (const char* images = std::getenv("VULKANTEST_SWAPCHAIN_IMAGES")) {
+    m_swapchainImages = toUint("VULKANTEST_SWAPCHAIN_IMAGES", images);
+  }
+
+  if (const char* presentWait = std::getenv("VULKANTEST_PRESENT_WAIT")) {
+    m_presentWait = std::string(presentWait) != "0";
+  }
+
+  if (const char* profile = std::getenv("VULKANTEST_PRESENT_MODE")) {
+    m_presentProfile = toPresentProfile("VULKANTEST_PRESENT_MODE", profile);
+  }
+
+  if (const char* pipelineCache = std::getenv("VULKANTEST_PIPELINE_CACHE")) {
+    m_pipelineCachePath = pipelineCache;
+  }
+
+  if (const char* pushConstants = std::getenv("VULKANTEST_PUSH_CONSTANTS")) {
+    m_pushConstants = std::string(pushConstants) != "0";
+  }
+
+  if (const char* mesh = std::getenv("VULKANTEST_MESH")) {
+    m_meshPath = mesh;
+  }
+
+  if (const char* instances = std::getenv("VULKANTEST_INSTANCES")) {
+    m_instanceCount = toPositiveUint("VULKANTEST_INSTANCES", instances);
+  }
+
+  if (const char* perDraw = std::getenv("VULKANTEST_INSTANCES_PER_DRAW")) {
+    m_instancesPerDraw = toUint("VULKANTEST_INSTANCES_PER_DRAW", perDraw);
+  }
+
+  if (const char* threads = std::getenv("VULKANTEST_RECORD_THREADS")) {
+    m_recordThreads = toUint("VULKANTEST_RECORD_THREADS", threads);
+  }
+
+  if (const char* rerecord = std::getenv("VULKANTEST_RERECORD")) {
+    m_rerecordFrames = std::string(rerecord) != "0";
+  }
+
+  if (const char* culling = std::getenv("VULKANTEST_GPU_CULLING")) {
+    m_gpuCulling = std::string(culling) != "0";
+  }
+
+  if (const char* async = std::getenv("VULKANTEST_ASYNC_COMPUTE")) {
+    m_asyncCompute = std::string(async) != "0";
+  }
+
+  if (const char* device = std::getenv("VULKANTEST_DEVICE")) {
+    m_device = device;
+  }
+
+  if (const char* csv = std::getenv("VULKANTEST_STATS_CSV")) {
+    m_statsCsvPath = csv;
+  }
+
+  if (const char* json = std::getenv("VULKANTEST_STATS_JSON")) {
+    m_statsJsonPath = json;
+  }
+}
+
+void Options::parse(int argc, char* argv[])
+{
+  parseEnvironment();
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg{ argv[i] };
+
+    const auto value = [&]() -> std::string {
+      if (i + 1 >= argc) {
+        throw std::runtime_error("missing value for " + arg);
+      }
+      return argv[++i];
+    };
+
+    if (arg == "--headless") {
+      m_headless = true;
+    }
+    else if (arg == "--frames") {
+      m_frameCount = toUint(arg, value());
+    }
+    else if (arg == "--no-timeline") {
+      m_timelineSemaphores = false;
+    }
+    else if (arg == "--frame-lag") {
+      m_frameLag = toUint(arg, value());
+    }
+    else if (arg == "--swapchain-images") {
+      m_swapchainImages = toUint(arg, value());
+    }
+    else if (arg == "--present-wait") {
+      m_presentWait = true;
+    }
+    else if (arg == "--present-mode") {
+      m_presentProfile = toPresentProfile(arg, value());
+    }
+    else if (arg == "--pipeline-cache") {
+      m_pipelineCachePath = value();
+    }
+    else if (arg == "--no-pipeline-cache") {
+      m_pipelineCachePath.clear();
+    }
+    else if (arg == "--no-push-constants") {
+      m_pushConstants = false;
+    }
+    else if (arg == "--mesh") {
+      m_meshPath = value();
+    }
+    else if (arg == "--instances") {
+      m_instanceCount = toPositiveUint(arg, value());
+    }
+    else if (arg == "--instances-per-draw") {
+      m_instancesPerDraw = toUint(arg, value());
+    }
+    else if (arg == "--record-threads") {
+      m_recordThreads = toUint(arg, value());
+    }
+    else if (arg == "--rerecord") {
+      m_rerecordFrames = true;
+    }
+    else if (arg == "--gpu-culling") {
+      m_gpuCulling = true;
+    }
+    else if (arg == "--no-async-compute") {
+      m_asyncCompute = false;
+    }
+    else if (arg == "--device") {
+      m_device = value();
+    }
+    else if (arg == "--stats-csv") {
+      m_statsCsvPath = value();
+    }
+    else if (arg == "--stats-json") {
+      m_statsJsonPath = value();
+    }
+    else {
+      throw std::runtime_error("unknown option " + arg);
+    }
+  }
+}
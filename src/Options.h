@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "PresentProfile.hpp"
+#include "Singleton.hpp"
+
+// Runtime options -- parsed once from the command line, environment variables act as defaults
+class Options final : public Singleton<Options>
+{
+public:
+  explicit Options(typename Singleton<Options>::token) {};
+
+  void parse(int argc, char* argv[]);
+
+  bool headless() const { return m_headless; }
+  uint32_t frameCount() const { return m_frameCount; }
+  const std::string& statsCsvPath() const { return m_statsCsvPath; }
+  const std::string& statsJsonPath() const { return m_statsJsonPath; }
+  bool timelineSemaphores() const { return m_timelineSemaphores; }
+  uint32_t frameLag() const { return m_frameLag; }
+  uint32_t swapchainImages() const { return m_swapchainImages; }
+  bool presentWait() const { return m_presentWait; }
+  PresentProfile presentProfile() const { return m_presentProfile; }
+  const std::string& pipelineCachePath() const { return m_pipelineCachePath; }
+  bool pushConstants() const { return m_pushConstants; }
+  const std::string& meshPath() const { return m_meshPath; }
+  uint32_t instanceCount() const { return m_instanceCount; }
+  uint32_t instancesPerDraw() const { return m_instancesPerDraw; }
+  uint32_t recordThreads() const { return m_recordThreads; }
+  bool rerecordFrames() const { return m_rerecordFrames; }
+  bool gpuCulling() const { return m_gpuCulling; }
+  bool asyncCompute() const { return m_asyncCompute; }
+  const std::string& device() const { return m_device; }
+
+private:
+  void parseEnvironment();
+  static uint32_t toUint(const std::string& name, const std::string& value);
+  static uint32_t toPositiveUint(const std::string& name, const std::string& value);
+  static PresentProfile toPresentProfile(const std::string& name, const std::string& value);
+
+  bool m_headless{ false };     // render to VK_EXT_headless_surface, no window and no input
+  uint32_t m_frameCount{ 1000 }; // frames to draw before exiting in headless mode
+  std::string m_statsCsvPath;    // frame-time telemetry export at exit, empty = off
+  std::string m_statsJsonPath;
+  bool m_timelineSemaphores{ true }; // use them for frame pacing when the device has them
+  uint32_t m_frameLag{ 0 };          // frames in flight, 0 = DEFAULT_FRAME_LAG
+  uint32_t m_swapchainImages{ 0 };   // requested swapchain image count, 0 = minImageCount + 1
+  bool m_presentWait{ false };       // hold the next frame until the previous present is done (VK_KHR_present_wait)
+  PresentProfile m_presentProfile{ PresentProfile::LowLatency }; // present mode policy, see SwapChain::choosePresentMode
+  std::string m_pipelineCachePath{ "pipeline_cache.bin" };         // VkPipelineCache kept between runs, empty = off
+  bool m_pushConstants{ true };                                    // per-draw model matrix via vkCmdPushConstants, implies m_rerecordFrames
+  std::string m_meshPath;                                          // MeshFormat file drawn instead of the built-in triangle
+  uint32_t m_instanceCount{ 1 };                                   // copies of the mesh drawn per frame, laid out on a grid
+  uint32_t m_instancesPerDraw{ 0 };                                // splits the instances into a draw list, 0 = one draw
+  uint32_t m_recordThreads{ 0 };                                   // secondary command buffers the draw list is split into, 0 = inline
+  bool m_rerecordFrames{ false };                                  // re-record on the uniform buffer path too (push constants always do)
+  bool m_gpuCulling{ false };                                      // compute frustum culling feeding an indirect draw
+  bool m_asyncCompute{ true };                                     // cull on a compute-only queue family when the device has one
+  std::string m_device;                                            // physical device override: index, name substring or UUID, empty = best score
+};
@@ -0,0 +1,46 @@
+#include <memory>
+
+#define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "PipelineBuilder.h"
+
+PipelineBuilder::PipelineBuilder()
+  : m_builds{}
+{}
+
+PipelineBuilder::~PipelineBuilder()
+{
+  finish();
+}
+
+std::future<VkPipeline> PipelineBuilder::build(Recipe recipe)
+{
+  // std::function needs a copyable target, the job shares the task instead of owning it
+  auto task = std::make_shared<std::packaged_task<VkPipeline()>>(std::move(recipe));
+  std::future<VkPipeline> result = task->get_future();
+
+  const JobSystem::Handle job = JobSystem::instance().submit([task]() {
+    (*task)(); // exceptions end up in the future
+  });
+
+  std::scoped_lock lock(m_mutex);
+  std::erase_if(m_builds, [](const JobSystem::Handle& build) { return JobSystem::finished(build); });
+  m_builds.push_back(job);
+
+  return result;
+}
+
+void PipelineBuilder::finish()
+{
+  std::vector<JobSystem::Handle> builds;
+  {
+    std::scoped_lock lock(m_mutex);
+    builds.swap(m_builds);
+  }
+
+  for (const auto& build : builds) {
+    JobSystem::instance().wait(build); // the packaged task never throws, failures are in the futures
+  }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
+#include "JobSystem.h"
+
+// Builds pipelines as JobSystem jobs.
+// build() returns immediately; the caller polls the future and keeps drawing with whatever it has until it is ready.
+class PipelineBuilder
+{
+public:
+  using Recipe = std::function<VkPipeline()>;
+
+  PipelineBuilder();
+  ~PipelineBuilder();
+
+  PipelineBuilder(const PipelineBuilder&) = delete;
+  PipelineBuilder& operator= (const PipelineBuilder&) = delete;
+
+  std::future<VkPipeline> build(Recipe recipe);
+
+  // helps the job system until every build handed out so far is done, so that a blocking get() on one of the
+  // futures can't sit behind queued jobs; also has to happen before the device goes away
+  void finish();
+
+private:
+  std::vector<JobSystem::Handle> m_builds;
+  std::mutex m_mutex;
+};
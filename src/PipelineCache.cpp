@@ -0,0 +1,128 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "PipelineCache.h"
+
+#include "ErrorHandling.hpp"
+
+PipelineCache::PipelineCache()
+  : m_device{ VK_NULL_HANDLE }
+  , m_pipelineCache{ VK_NULL_HANDLE }
+  , m_properties{}
+  , m_path{}
+{}
+
+void PipelineCache::create(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& path)
+{
+  m_device = device;
+  m_path = path;
+  vkGetPhysicalDeviceProperties(physicalDevice, &m_properties);
+
+  std::vector<char> data;
+  if (!m_path.empty()) {
+    std::ifstream file(m_path, std::ios::ate | std::ios::binary);
+    if (file.is_open()) {
+      data.resize(static_cast<size_t>(file.tellg()));
+      file.seekg(0);
+      file.read(data.data(), data.size());
+    }
+
+    if (!file.is_open() || !file) {
+      data.clear();
+      logger << "pipeline cache: no usable " << m_path << ", starting cold" << std::endl;
+    }
+    else if (!isCompatible(data)) {
+      data.clear();
+      logger << "pipeline cache: " << m_path << " was written by another device or driver, starting cold" << std::endl;
+    }
+    else {
+      logger << "pipeline cache: loaded " << data.size() << " bytes from " << m_path << std::endl;
+    }
+  }
+
+  const VkPipelineCacheCreateInfo createInfo {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+    .initialDataSize = data.size(),
+    .pInitialData = data.empty() ? nullptr : data.data()
+  };
+
+  RESULT_HANDLER(vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_pipelineCache), "vkCreatePipelineCache");
+}
+
+bool PipelineCache::isCompatible(const std::vector<char>& data) const
+{
+  VkPipelineCacheHeaderVersionOne header;
+  if (data.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+
+  return header.headerSize >= sizeof(header)
+    && header.headerSize <= data.size()
+    && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+    && header.vendorID == m_properties.vendorID
+    && header.deviceID == m_properties.deviceID
+    && std::memcmp(header.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+// called at shutdown -- failing to persist the cache only costs the next cold start, so it is logged and not thrown
+void PipelineCache::save() const
+{
+  if (!m_pipelineCache || m_path.empty()) {
+    return;
+  }
+
+  size_t size{ 0 };
+  if (vkGetPipelineCacheData(m_device, m_pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0) {
+    return;
+  }
+
+  std::vector<char> data(size);
+  if (vkGetPipelineCacheData(m_device, m_pipelineCache, &size, data.data()) != VK_SUCCESS) {
+    logger << "pipeline cache: vkGetPipelineCacheData failed, not saved" << std::endl;
+    return;
+  }
+  data.resize(size);
+
+  const std::string tmpPath = m_path + ".tmp";
+  {
+    std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+    file.close();
+
+    if (!file) {
+      logger << "pipeline cache: failed to write " << tmpPath << std::endl;
+      std::error_code ignored;
+      std::filesystem::remove(tmpPath, ignored);
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(tmpPath, m_path, error);
+  if (error) {
+    logger << "pipeline cache: failed to replace " << m_path << ": " << error.message() << std::endl;
+    std::filesystem::remove(tmpPath, error);
+    return;
+  }
+
+  logger << "pipeline cache: saved " << data.size() << " bytes to " << m_path << std::endl;
+}
+
+void PipelineCache::cleanup()
+{
+  if (m_pipelineCache) {
+    vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+    m_pipelineCache = VK_NULL_HANDLE;
+  }
+}
+
+VkPipelineCache PipelineCache::handle() const
+{
+  return m_pipelineCache;
+}
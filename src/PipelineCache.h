@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// VkPipelineCache persisted between runs.
+// The file is only used when its header matches the current vendor, device and driver (pipelineCacheUUID),
+// and it is written to a temporary file first and renamed over the old one, so a crash never leaves a torn cache behind.
+class PipelineCache
+{
+public:
+  PipelineCache();
+
+  void create(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& path);
+  void save() const;
+  void cleanup();
+
+  VkPipelineCache handle() const;
+
+private:
+  bool isCompatible(const std::vector<char>& data) const;
+
+  VkDevice m_device;
+  VkPipelineCache m_pipelineCache;
+  VkPhysicalDeviceProperties m_properties;
+  std::string m_path; // empty = in-memory only
+};
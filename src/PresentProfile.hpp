@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// Named presentation policies, resolved against the surface's modes by SwapChain::choosePresentMode
+enum class PresentProfile : uint32_t
+{
+  LowLatency, // MAILBOX, else FIFO -- newest frame wins, the GPU renders flat out, never tears
+  VSync,      // FIFO_RELAXED, else FIFO -- one frame per vblank, a late frame tears instead of stalling
+  PowerSave,  // FIFO -- strictly capped at the refresh rate, the GPU idles between vblanks
+  Uncapped,   // IMMEDIATE, else MAILBOX -- no pacing at all, for benchmarks
+  Count
+};
+
+inline const char* to_string(PresentProfile profile)
+{
+  switch (profile) {
+    case PresentProfile::LowLatency: return "low-latency";
+    case PresentProfile::VSync:      return "vsync";
+    case PresentProfile::PowerSave:  return "power-save";
+    case PresentProfile::Uncapped:   return "uncapped";
+    default:                         return "unknown";
+  }
+}
+
+inline std::optional<PresentProfile> parsePresentProfile(const std::string& name)
+{
+  for (uint32_t i = 0; i < static_cast<uint32_t>(PresentProfile::Count); ++i) {
+    if (name == to_string(static_cast<PresentProfile>(i))) {
+      return static_cast<PresentProfile>(i);
+    }
+  }
+
+  return std::nullopt;
+}
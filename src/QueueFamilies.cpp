@@ -4,8 +4,14 @@
 
 #include <vector>
 #include "QueueFamilies.h"
+#include "SurfaceCache.h"
 
 QueueFamilyIndices QueueFamilies::find(VkPhysicalDevice device, VkSurfaceKHR surface) const
+{
+  return SurfaceCache::instance().queueFamilies(device, surface);
+}
+
+QueueFamilyIndices QueueFamilies::query(VkPhysicalDevice device, VkSurfaceKHR surface) const
 {
   QueueFamilyIndices indices{};
 
@@ -39,5 +45,25 @@ QueueFamilyIndices QueueFamilies::find(VkPhysicalDevice device, VkSurfaceKHR sur
     i++;
   }
 
+  for (uint32_t family = 0; family < queueFamilyCount; ++family)
+  {
+    const VkQueueFlags flags = queueFamilies[family].queueFlags;
+    if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+    {
+      indices.transferFamily = family;
+      break;
+    }
+  }
+
+  for (uint32_t family = 0; family < queueFamilyCount; ++family)
+  {
+    const VkQueueFlags flags = queueFamilies[family].queueFlags;
+    if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+    {
+      indices.computeFamily = family;
+      break;
+    }
+  }
+
   return indices;
 }
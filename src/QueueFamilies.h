@@ -7,6 +7,8 @@ struct QueueFamilyIndices
 {
   std::optional<uint32_t> graphicsFamily;
   std::optional<uint32_t> presentFamily;
+  std::optional<uint32_t> transferFamily; // transfer-only family (DMA engine), if the device has one
+  std::optional<uint32_t> computeFamily;  // compute family without graphics (async compute), if the device has one
 
   bool isComplete()
   {
@@ -22,7 +24,11 @@ public:
 private:
 
 public:
+  // cached per device and surface, see SurfaceCache
   QueueFamilyIndices find(VkPhysicalDevice device, VkSurfaceKHR surface) const;
+
+  // asks the driver every time
+  QueueFamilyIndices query(VkPhysicalDevice device, VkSurfaceKHR surface) const;
 };
 
 
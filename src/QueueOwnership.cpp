@@ -0,0 +1,57 @@
+#define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "QueueOwnership.h"
+
+QueueOwnershipTransfer::QueueOwnershipTransfer(uint32_t srcFamily, uint32_t dstFamily)
+  : m_srcFamily{ srcFamily }
+  , m_dstFamily{ dstFamily }
+{}
+
+bool QueueOwnershipTransfer::crossesFamilies() const
+{
+  return m_srcFamily != m_dstFamily;
+}
+
+// the release half makes the writes available, the destination stage and access are ignored
+void QueueOwnershipTransfer::release(VkCommandBuffer commandBuffer, const std::vector<VkBuffer>& buffers, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess) const
+{
+  if (!crossesFamilies() || buffers.empty()) {
+    return;
+  }
+
+  const std::vector<VkBufferMemoryBarrier> release{ barriers(buffers, srcAccess, 0) };
+  vkCmdPipelineBarrier(commandBuffer, srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, static_cast<uint32_t>(release.size()), release.data(), 0, nullptr);
+}
+
+// the acquire half makes them visible; waitStage is the semaphore wait's pWaitDstStageMask, only a source stage
+// overlapping it orders the acquire after the wait
+void QueueOwnershipTransfer::acquire(VkCommandBuffer commandBuffer, const std::vector<VkBuffer>& buffers, VkPipelineStageFlags waitStage, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) const
+{
+  if (!crossesFamilies() || buffers.empty()) {
+    return;
+  }
+
+  const std::vector<VkBufferMemoryBarrier> acquire{ barriers(buffers, 0, dstAccess) };
+  vkCmdPipelineBarrier(commandBuffer, waitStage, dstStage, 0, 0, nullptr, static_cast<uint32_t>(acquire.size()), acquire.data(), 0, nullptr);
+}
+
+std::vector<VkBufferMemoryBarrier> QueueOwnershipTransfer::barriers(const std::vector<VkBuffer>& buffers, VkAccessFlags srcAccess, VkAccessFlags dstAccess) const
+{
+  std::vector<VkBufferMemoryBarrier> result;
+  result.reserve(buffers.size());
+  for (const VkBuffer buffer : buffers) {
+    result.push_back({
+      .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+      .srcAccessMask = srcAccess,
+      .dstAccessMask = dstAccess,
+      .srcQueueFamilyIndex = m_srcFamily,
+      .dstQueueFamilyIndex = m_dstFamily,
+      .buffer = buffer,
+      .offset = 0,
+      .size = VK_WHOLE_SIZE
+    });
+  }
+  return result;
+}
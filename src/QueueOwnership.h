@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+// Queue family ownership transfer of VK_SHARING_MODE_EXCLUSIVE buffers.
+// release() is recorded on a queue of the source family after its last write, acquire() on one of the destination family
+// before its first read, and the destination's submission waits on a semaphore the source's signals. The acquire starts
+// at the stages that wait waits in, which chains it after the semaphore and with that after the release.
+// Contents the destination overwrites anyway need neither, their new owner simply starts using them.
+class QueueOwnershipTransfer
+{
+public:
+  QueueOwnershipTransfer(uint32_t srcFamily, uint32_t dstFamily);
+
+  // only transfers between two families record barriers, within one family use an ordinary pipeline barrier
+  bool crossesFamilies() const;
+
+  void release(VkCommandBuffer commandBuffer, const std::vector<VkBuffer>& buffers, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess) const;
+  void acquire(VkCommandBuffer commandBuffer, const std::vector<VkBuffer>& buffers, VkPipelineStageFlags waitStage, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) const;
+
+private:
+  std::vector<VkBufferMemoryBarrier> barriers(const std::vector<VkBuffer>& buffers, VkAccessFlags srcAccess, VkAccessFlags dstAccess) const;
+
+  uint32_t m_srcFamily;
+  uint32_t m_dstFamily;
+};
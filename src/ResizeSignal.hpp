@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Hands framebuffer resizes from the window thread over to the render thread.
+// The window thread never waits: it publishes the new extent and bumps the epoch.
+// The render thread compares epochs at its next frame boundary and recreates the swapchain itself.
+class ResizeSignal
+{
+public:
+  using clock = std::chrono::steady_clock;
+
+  struct Request
+  {
+    uint64_t epoch;
+    uint32_t width;
+    uint32_t height;
+    bool resized;            // false when only a rebuild at the same size was requested
+    clock::time_point since; // oldest resize not yet picked up by the render thread
+  };
+
+  // window thread
+  void publish(uint32_t width, uint32_t height)
+  {
+    m_extent.store(pack(width, height), std::memory_order_relaxed);
+
+    clock::rep expected{ 0 };
+    m_pendingSince.compare_exchange_strong(expected, clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+
+    m_epoch.fetch_add(1, std::memory_order_release);
+
+    if (width && height) {
+      std::scoped_lock lock(m_mutex); // only to not lose the wakeup of a minimized render thread
+      m_cv.notify_one();
+    }
+  }
+
+  // window thread: have the render thread rebuild the swapchain at the current size
+  void requestRecreate()
+  {
+    m_epoch.fetch_add(1, std::memory_order_release);
+  }
+
+  void shutdown()
+  {
+    std::scoped_lock lock(m_mutex);
+    m_shutdown.store(true);
+    m_cv.notify_all();
+  }
+
+  // render thread: true (and the latest extent) when something was published after seenEpoch
+  bool consume(uint64_t& seenEpoch, Request& request)
+  {
+    const uint64_t epoch = m_epoch.load(std::memory_order_acquire);
+    if (epoch == seenEpoch) {
+      return false;
+    }
+    seenEpoch = epoch;
+
+    const uint64_t extent = m_extent.load(std::memory_order_relaxed);
+    const clock::rep since = m_pendingSince.exchange(0, std::memory_order_relaxed);
+
+    request = {
+      .epoch = epoch,
+      .width = static_cast<uint32_t>(extent >> 32),
+      .height = static_cast<uint32_t>(extent),
+      .resized = since != 0,
+      .since = since ? clock::time_point(clock::duration(since)) : clock::now()
+    };
+    return true;
+  }
+
+  // render thread: sleeps while the window is minimized, false once shut down
+  bool waitUntilVisible()
+  {
+    if (visible() || m_shutdown.load()) {
+      return !m_shutdown.load();
+    }
+
+    std::unique_lock lock(m_mutex);
+    m_cv.wait(lock, [this]() { return visible() || m_shutdown.load(); });
+    return !m_shutdown.load();
+  }
+
+  uint64_t epoch() const { return m_epoch.load(std::memory_order_acquire); }
+
+  uint32_t width() const { return static_cast<uint32_t>(m_extent.load(std::memory_order_relaxed) >> 32); }
+  uint32_t height() const { return static_cast<uint32_t>(m_extent.load(std::memory_order_relaxed)); }
+
+private:
+  static uint64_t pack(uint32_t width, uint32_t height) { return (uint64_t{ width } << 32) | height; }
+
+  bool visible() const
+  {
+    const uint64_t extent = m_extent.load(std::memory_order_relaxed);
+    return (extent >> 32) && static_cast<uint32_t>(extent);
+  }
+
+  std::atomic<uint64_t> m_extent{ 0 };
+  std::atomic<uint64_t> m_epoch{ 0 };
+  std::atomic<clock::rep> m_pendingSince{ 0 };
+  std::atomic<bool> m_shutdown{ false };
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+};
@@ -5,7 +5,9 @@
 const uint32_t WIDTH = 600;
 const uint32_t HEIGHT = 600;
 
-const int MAX_FRAMES_IN_FLIGHT = 3;
+// per-frame resources are allocated for MAX_FRAMES_IN_FLIGHT, the frame lag actually used is a runtime setting
+const int MAX_FRAMES_IN_FLIGHT = 4;
+const int DEFAULT_FRAME_LAG = 3;
 
 const std::vector<const char*> validationLayers {
     "VK_LAYER_KHRONOS_validation",
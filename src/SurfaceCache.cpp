@@ -0,0 +1,68 @@
+#define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "SurfaceCache.h"
+
+#include "EnumerateScheme.hpp"
+
+QueueFamilyIndices SurfaceCache::queueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface)
+{
+  std::scoped_lock lock(m_mutex);
+
+  Entry& entry = m_entries[{ device, surface }];
+  if (!entry.queueFamilies) {
+    entry.queueFamilies = QueueFamilies::instance().query(device, surface);
+  }
+  return *entry.queueFamilies;
+}
+
+SwapChainSupportDetails SurfaceCache::support(VkPhysicalDevice device, VkSurfaceKHR surface)
+{
+  VkSurfaceCapabilitiesKHR capabilities;
+  RESULT_HANDLER(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &capabilities), "vkGetPhysicalDeviceSurfaceCapabilitiesKHR");
+
+  std::scoped_lock lock(m_mutex);
+
+  Entry& entry = m_entries[{ device, surface }];
+  if (entry.support && !sameExceptExtent(entry.support->capabilities, capabilities)) {
+    logger << "surface capabilities changed, querying formats, present modes and queue families again" << std::endl;
+    entry = {};
+  }
+
+  if (!entry.support) {
+    const auto formats = enumerate<VkSurfaceFormatKHR>(device, surface);
+    RESULT_HANDLER_EX(formats.empty(), VK_ERROR_INITIALIZATION_FAILED, "No surface formats offered by Vulkan!");
+
+    const auto presentModes = enumerate<VkPresentModeKHR, VkPhysicalDevice, VkSurfaceKHR>(device, surface);
+    RESULT_HANDLER_EX(presentModes.empty(), VK_ERROR_INITIALIZATION_FAILED, "No surface presentModes offered by Vulkan!");
+
+    entry.support = SwapChainSupportDetails{
+      .capabilities = capabilities,
+      .formats = formats,
+      .presentModes = presentModes
+    };
+  }
+
+  entry.support->capabilities = capabilities;
+  return *entry.support;
+}
+
+void SurfaceCache::invalidate(VkSurfaceKHR surface)
+{
+  std::scoped_lock lock(m_mutex);
+
+  std::erase_if(m_entries, [surface](const auto& entry) { return entry.first.second == surface; });
+}
+
+// the image extent limits may track the window as well, everything else only changes with the surface or display
+bool SurfaceCache::sameExceptExtent(const VkSurfaceCapabilitiesKHR& a, const VkSurfaceCapabilitiesKHR& b)
+{
+  return a.minImageCount == b.minImageCount
+    && a.maxImageCount == b.maxImageCount
+    && a.maxImageArrayLayers == b.maxImageArrayLayers
+    && a.supportedTransforms == b.supportedTransforms
+    && a.currentTransform == b.currentTransform
+    && a.supportedCompositeAlpha == b.supportedCompositeAlpha
+    && a.supportedUsageFlags == b.supportedUsageFlags;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "QueueFamilies.h"
+#include "SwapChain.h"
+#include "Singleton.hpp"
+
+// Capability queries per (physical device, surface), so that recreating the swapchain on a resize does not go back to
+// the driver for what cannot have changed. Only the surface capabilities are re-read every time -- the current extent
+// follows the window. Queue family support, formats and present modes are kept until the surface is lost or its
+// capabilities other than the extent come back different.
+class SurfaceCache final : public Singleton<SurfaceCache>
+{
+public:
+  explicit SurfaceCache(typename Singleton<SurfaceCache>::token) {}
+
+  QueueFamilyIndices queueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
+  SwapChainSupportDetails support(VkPhysicalDevice device, VkSurfaceKHR surface);
+
+  // before the surface is destroyed, a new one may get the same handle
+  void invalidate(VkSurfaceKHR surface);
+
+private:
+  using Key = std::pair<VkPhysicalDevice, VkSurfaceKHR>;
+
+  struct Entry
+  {
+    std::optional<QueueFamilyIndices> queueFamilies;
+    std::optional<SwapChainSupportDetails> support;
+  };
+
+  static bool sameExceptExtent(const VkSurfaceCapabilitiesKHR& a, const VkSurfaceCapabilitiesKHR& b);
+
+  std::mutex m_mutex; // device selection runs on the main thread, swapchain recreation on the render thread
+  std::map<Key, Entry> m_entries;
+};
@@ -7,11 +7,17 @@
 
 #include "SwapChain.h"
 #include "QueueFamilies.h"
+#include "SurfaceCache.h"
 
 #include "EnumerateScheme.hpp"
 
 SwapChain::SwapChain()
-  : m_swapChain{ VK_NULL_HANDLE } // has to be NULL -- signifies that there's no swapchain
+  : m_windowExtent{}
+  , m_requestedImageCount{ 0 }
+  , m_presentProfile{ PresentProfile::LowLatency }
+  , m_presentMode{ VK_PRESENT_MODE_FIFO_KHR }
+  , m_logPresentMode{ true }
+  , m_swapChain{ VK_NULL_HANDLE } // has to be NULL -- signifies that there's no swapchain
   , m_swapChainImages{}
   , m_swapChainImageFormat{}
   , m_swapChainExtent{}
@@ -27,13 +33,7 @@ VkExtent2D SwapChain::chooseExtent(const VkSurfaceCapabilitiesKHR& capabilities)
   }
   else
   {
-    int width{ 0 }, height{ 0 };
-    glfwGetFramebufferSize(m_pWindow, &width, &height);
-
-    VkExtent2D actualExtent {
-        static_cast<uint32_t>(width),
-        static_cast<uint32_t>(height)
-    };
+    VkExtent2D actualExtent = m_windowExtent;
 
     actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
     actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
@@ -55,40 +55,62 @@ VkSurfaceFormatKHR SwapChain::chooseSurfaceFormat(const std::vector<VkSurfaceFor
   return availableFormats[0];
 }
 
+namespace
+{
+  const char* presentModeName(VkPresentModeKHR presentMode)
+  {
+    switch (presentMode) {
+      case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "IMMEDIATE";
+      case VK_PRESENT_MODE_MAILBOX_KHR:      return "MAILBOX";
+      case VK_PRESENT_MODE_FIFO_KHR:         return "FIFO";
+      case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+      default:                               return "unknown";
+    }
+  }
+}
+
 VkPresentModeKHR SwapChain::choosePresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) const
 {
-  for (const auto& availablePresentMode : availablePresentModes)
+  // in order of preference, FIFO is the fallback every implementation has to support
+  std::vector<VkPresentModeKHR> preferred;
+  switch (m_presentProfile) {
+    case PresentProfile::LowLatency: preferred = { VK_PRESENT_MODE_MAILBOX_KHR }; break;
+    case PresentProfile::VSync:      preferred = { VK_PRESENT_MODE_FIFO_RELAXED_KHR }; break;
+    case PresentProfile::PowerSave:  preferred = {}; break;
+    case PresentProfile::Uncapped:   preferred = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR }; break;
+    default: break;
+  }
+
+  for (const auto& presentMode : preferred)
   {
-    if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+    if (std::find(availablePresentModes.begin(), availablePresentModes.end(), presentMode) != availablePresentModes.end())
     {
-      return availablePresentMode;
+      return presentMode;
     }
   }
 
   return VK_PRESENT_MODE_FIFO_KHR;
 }
 
-SwapChainSupportDetails SwapChain::querySupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const
+void SwapChain::setPresentProfile(PresentProfile profile)
 {
-  const auto formats = enumerate<VkSurfaceFormatKHR>(physicalDevice, surface);
-  RESULT_HANDLER_EX(formats.empty(), VK_ERROR_INITIALIZATION_FAILED, "No surface formats offered by Vulkan!");
-
-  const auto presentModes = enumerate<VkPresentModeKHR, VkPhysicalDevice, VkSurfaceKHR>(physicalDevice, surface);
-  RESULT_HANDLER_EX(presentModes.empty(), VK_ERROR_INITIALIZATION_FAILED, "No surface presentModes offered by Vulkan!");
-
-  SwapChainSupportDetails details {
-    .formats = formats,
-    .presentModes = presentModes
-  };
+  m_logPresentMode |= profile != m_presentProfile;
+  m_presentProfile = profile;
+}
 
-  vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &details.capabilities);
+VkPresentModeKHR SwapChain::presentMode() const
+{
+  return m_presentMode;
+}
 
-  return details;
+SwapChainSupportDetails SwapChain::querySupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) const
+{
+  return SurfaceCache::instance().support(physicalDevice, surface);
 }
 
-void SwapChain::create(GLFWwindow* pWindow, VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, VkSwapchainKHR oldSwapChain /* = VK_NULL_HANDLE */)
+void SwapChain::create(VkExtent2D windowExtent, VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, VkSwapchainKHR oldSwapChain /* = VK_NULL_HANDLE */)
 {
-  m_pWindow = pWindow;
+  m_windowExtent = windowExtent;
   m_device = device;
   m_physicalDevice = physicalDevice;
   m_surface = surface;
@@ -103,9 +125,14 @@ void SwapChain::createKHR(VkSwapchainKHR oldSwapChain /* = VK_NULL_HANDLE */)
 
   const VkSurfaceFormatKHR surfaceFormat = chooseSurfaceFormat(swapChainSupport.formats);
   const VkPresentModeKHR presentMode = choosePresentMode(swapChainSupport.presentModes);
+  if (presentMode != m_presentMode || m_logPresentMode)
+  {
+    m_logPresentMode = false;
+    logger << "present mode: " << presentModeName(presentMode) << " (profile " << to_string(m_presentProfile) << ")" << std::endl;
+  }
   const VkExtent2D extent = chooseExtent(swapChainSupport.capabilities);
 
-  uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+  uint32_t imageCount = m_requestedImageCount ? std::max(m_requestedImageCount, swapChainSupport.capabilities.minImageCount) : swapChainSupport.capabilities.minImageCount + 1;
   if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount)
   {
     imageCount = swapChainSupport.capabilities.maxImageCount;
@@ -148,6 +175,7 @@ void SwapChain::createKHR(VkSwapchainKHR oldSwapChain /* = VK_NULL_HANDLE */)
   
   m_swapChainImageFormat = surfaceFormat.format;
   m_swapChainExtent = extent;
+  m_presentMode = presentMode;
 }
 
 void SwapChain::killSwapchainImageViews() 
@@ -243,6 +271,11 @@ VkRect2D SwapChain::scissor() const
   };
 }
 
+VkFormat SwapChain::imageFormat() const
+{
+  return m_swapChainImageFormat;
+}
+
 VkAttachmentDescription SwapChain::colorAttachment() const
 {
   return {
@@ -291,3 +324,13 @@ VkExtent2D SwapChain::extent() const
 {
   return m_swapChainExtent;
 }
+
+uint32_t SwapChain::imageCount() const
+{
+  return static_cast<uint32_t>(m_swapChainImages.size());
+}
+
+void SwapChain::requestImageCount(uint32_t imageCount)
+{
+  m_requestedImageCount = imageCount;
+}
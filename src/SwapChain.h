@@ -2,6 +2,8 @@
 #include <vector>
 #include <string>
 
+#include "PresentProfile.hpp"
+
 struct SwapChainSupportDetails
 {
   VkSurfaceCapabilitiesKHR capabilities;
@@ -15,7 +17,7 @@ public:
   SwapChain();
 
 public:
-  void create(GLFWwindow* pWindow, VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
+  void create(VkExtent2D windowExtent, VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
   void createFramebuffers(VkRenderPass renderPass);
   void killFramebuffers();
   void killSwapchainImageViews();
@@ -33,6 +35,11 @@ public:
   VkResult acquireNextImageKHR(VkSemaphore imageAvailableSemaphore, uint32_t* pImageIndex) const;
   VkSwapchainKHR swapChains() const;
   VkExtent2D extent() const;
+  VkFormat imageFormat() const;
+  uint32_t imageCount() const;
+  void requestImageCount(uint32_t imageCount);
+  void setPresentProfile(PresentProfile profile); // takes effect at the next create()
+  VkPresentModeKHR presentMode() const;
   VkExtent2D chooseExtent(const VkSurfaceCapabilitiesKHR& capabilities) const;
 
 private:
@@ -43,7 +50,11 @@ private:
   void createImageViews();
   
 
-  GLFWwindow* m_pWindow;
+  VkExtent2D m_windowExtent; // used when the surface leaves the extent up to the swapchain
+  uint32_t m_requestedImageCount; // 0 = minImageCount + 1
+  PresentProfile m_presentProfile;
+  VkPresentModeKHR m_presentMode;
+  bool m_logPresentMode; // set when the profile changed, so the choice gets reported even if the mode did not
   VkDevice m_device;
   VkPhysicalDevice m_physicalDevice;
   VkSurfaceKHR m_surface;
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+#include "Telemetry.h"
+
+uint32_t Histogram::bucketIndex(uint64_t value)
+{
+  if (value < SUB_BUCKETS) {
+    return static_cast<uint32_t>(value);
+  }
+
+  const uint32_t shift = static_cast<uint32_t>(std::bit_width(value)) - 1 - SUB_BITS;
+  const uint32_t mantissa = static_cast<uint32_t>(value >> shift) - SUB_BUCKETS;
+
+  return (shift + 1) * SUB_BUCKETS + mantissa;
+}
+
+uint64_t Histogram::bucketUpperBound(uint32_t index)
+{
+  if (index < SUB_BUCKETS) {
+    return index;
+  }
+
+  const uint32_t shift = index / SUB_BUCKETS - 1;
+  const uint64_t mantissa = index % SUB_BUCKETS;
+
+  return ((SUB_BUCKETS + mantissa) << shift) + ((uint64_t{ 1 } << shift) - 1);
+}
+
+void Histogram::record(uint64_t nanoseconds)
+{
+  m_buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+  uint64_t max = m_max.load(std::memory_order_relaxed);
+  while (nanoseconds > max && !m_max.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+  }
+}
+
+void Histogram::reset()
+{
+  for (auto& bucket : m_buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  m_count.store(0, std::memory_order_relaxed);
+  m_sum.store(0, std::memory_order_relaxed);
+  m_max.store(0, std::memory_order_relaxed);
+}
+
+Histogram::Summary Histogram::summary() const
+{
+  constexpr double toMs = 1.0e-6;
+
+  // snapshot first -- the render thread keeps recording while we read
+  std::array<uint64_t, BUCKETS> buckets;
+  uint64_t total{ 0 };
+  for (uint32_t i = 0; i < BUCKETS; ++i) {
+    buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    total += buckets[i];
+  }
+
+  Summary summary {
+    .count = total,
+    .mean = total ? m_sum.load(std::memory_order_relaxed) * toMs / total : 0.0,
+    .p50 = 0.0,
+    .p95 = 0.0,
+    .p99 = 0.0,
+    .max = m_max.load(std::memory_order_relaxed) * toMs
+  };
+
+  const auto percentile = [&](double p) {
+    const uint64_t rank = static_cast<uint64_t>(p * total + 0.5);
+    uint64_t seen{ 0 };
+    for (uint32_t i = 0; i < BUCKETS; ++i) {
+      seen += buckets[i];
+      if (seen >= rank && seen) {
+        return std::min(bucketUpperBound(i) * toMs, summary.max);
+      }
+    }
+    return summary.max;
+  };
+
+  summary.p50 = percentile(0.50);
+  summary.p95 = percentile(0.95);
+  summary.p99 = percentile(0.99);
+
+  return summary;
+}
+
+const char* Telemetry::name(Stage stage)
+{
+  switch (stage) {
+    case Stage::PresentWait:     return "present_wait";
+    case Stage::FenceWait:       return "fence_wait";
+    case Stage::Acquire:         return "acquire";
+    case Stage::UpdateUniform:   return "update_uniform";
+    case Stage::Transforms:      return "transforms";
+    case Stage::Record:          return "record";
+    case Stage::Submit:          return "submit";
+    case Stage::Present:         return "present";
+    case Stage::Frame:           return "frame";
+    case Stage::GpuFrame:        return "gpu_frame";
+    case Stage::ResizeToPresent: return "resize_to_present";
+    default:                     return "unknown";
+  }
+}
+
+void Telemetry::record(Stage stage, std::chrono::steady_clock::duration elapsed)
+{
+  const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  m_stages[static_cast<size_t>(stage)].record(ns > 0 ? static_cast<uint64_t>(ns) : 0);
+}
+
+void Telemetry::reset()
+{
+  for (auto& stage : m_stages) {
+    stage.reset();
+  }
+}
+
+void Telemetry::report(std::ostream& out) const
+{
+  const auto flags = out.flags();
+
+  out << "stage                  count     mean      p50      p95      p99      max  (ms)" << std::endl;
+  for (uint32_t i = 0; i < static_cast<uint32_t>(Stage::Count); ++i) {
+    const Histogram::Summary s = m_stages[i].summary();
+    out << std::left << std::setw(19) << name(static_cast<Stage>(i)) << std::right
+      << std::setw(10) << s.count << std::fixed << std::setprecision(3)
+      << std::setw(9) << s.mean
+      << std::setw(9) << s.p50
+      << std::setw(9) << s.p95
+      << std::setw(9) << s.p99
+      << std::setw(9) << s.max << std::endl;
+  }
+
+  out.flags(flags);
+}
+
+void Telemetry::exportCsv(const std::string& path) const
+{
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    throw std::runtime_error("failed to open " + path);
+  }
+
+  file << "stage,count,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+  for (uint32_t i = 0; i < static_cast<uint32_t>(Stage::Count); ++i) {
+    const Histogram::Summary s = m_stages[i].summary();
+    file << name(static_cast<Stage>(i)) << ',' << s.count << ',' << s.mean << ','
+      << s.p50 << ',' << s.p95 << ',' << s.p99 << ',' << s.max << '\n';
+  }
+}
+
+void Telemetry::exportJson(const std::string& path) const
+{
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    throw std::runtime_error("failed to open " + path);
+  }
+
+  file << "{\n  \"unit\": \"ms\",\n  \"stages\": {";
+  for (uint32_t i = 0; i < static_cast<uint32_t>(Stage::Count); ++i) {
+    const Histogram::Summary s = m_stages[i].summary();
+    file << (i ? "," : "") << "\n    \"" << name(static_cast<Stage>(i)) << "\": { "
+      << "\"count\": " << s.count << ", "
+      << "\"mean\": " << s.mean << ", "
+      << "\"p50\": " << s.p50 << ", "
+      << "\"p95\": " << s.p95 << ", "
+      << "\"p99\": " << s.p99 << ", "
+      << "\"max\": " << s.max << " }";
+  }
+  file << "\n  }\n}\n";
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "Singleton.hpp"
+
+// Lock-free log-linear histogram of durations in nanoseconds.
+// Every power of two is split into SUB_BUCKETS linear buckets, so percentiles are accurate to ~6%.
+class Histogram
+{
+public:
+  static constexpr uint32_t SUB_BITS = 4;
+  static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BITS;
+  static constexpr uint32_t BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+  struct Summary {
+    uint64_t count;
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+  };
+
+  void record(uint64_t nanoseconds);
+  void reset();
+
+  Summary summary() const; // all values in milliseconds
+
+private:
+  static uint32_t bucketIndex(uint64_t value);
+  static uint64_t bucketUpperBound(uint32_t index);
+
+  std::array<std::atomic<uint64_t>, BUCKETS> m_buckets{};
+  std::atomic<uint64_t> m_count{ 0 };
+  std::atomic<uint64_t> m_sum{ 0 };
+  std::atomic<uint64_t> m_max{ 0 };
+};
+
+// Per-stage CPU timings of Application::drawFrame, plus the GPU time of its render pass
+// and the latency from a window resize to the first frame presented at the new size
+class Telemetry final : public Singleton<Telemetry>
+{
+public:
+  enum class Stage : uint32_t {
+    PresentWait,
+    FenceWait,
+    Acquire,
+    UpdateUniform,
+    Transforms,
+    Record,
+    Submit,
+    Present,
+    Frame,
+    GpuFrame,
+    ResizeToPresent,
+    Count
+  };
+
+  explicit Telemetry(typename Singleton<Telemetry>::token) {}
+
+  void record(Stage stage, std::chrono::steady_clock::duration elapsed);
+  void reset();
+
+  void report(std::ostream& out) const;
+  void exportCsv(const std::string& path) const;
+  void exportJson(const std::string& path) const;
+
+  static const char* name(Stage stage);
+
+private:
+  std::array<Histogram, static_cast<size_t>(Stage::Count)> m_stages;
+};
+
+// Records the lifetime of the scope into a Telemetry stage
+class ScopedStageTimer
+{
+public:
+  explicit ScopedStageTimer(Telemetry::Stage stage)
+    : m_stage(stage)
+    , m_start(std::chrono::steady_clock::now())
+  {}
+
+  ~ScopedStageTimer()
+  {
+    Telemetry::instance().record(m_stage, std::chrono::steady_clock::now() - m_start);
+  }
+
+  ScopedStageTimer(const ScopedStageTimer&) = delete;
+  ScopedStageTimer& operator= (const ScopedStageTimer&) = delete;
+
+private:
+  Telemetry::Stage m_stage;
+  std::chrono::steady_clock::time_point m_start;
+};
@@ -11,15 +11,16 @@ public:
     return StartTime != clock::time_point{};
   }
 
-  void Start() {
+  // at: when it really happened, e.g. the timestamp of the input event that toggled it
+  void Start(clock::time_point at = clock::now()) {
     if (!IsRunning()) {
-      StartTime = clock::now();
+      StartTime = at;
     }
   }
 
-  void Stop() {
+  void Stop(clock::time_point at = clock::now()) {
     if (IsRunning()) {
-      ElapsedTime += clock::now() - StartTime;
+      ElapsedTime += at - StartTime;
       StartTime = {};
     }
   }
@@ -29,10 +30,10 @@ public:
     ElapsedTime = {};
   }
 
-  clock::duration GetElapsed() {
+  clock::duration GetElapsed(clock::time_point at = clock::now()) const {
     auto result = ElapsedTime;
     if (IsRunning()) {
-      result += clock::now() - StartTime;
+      result += at - StartTime;
     }
     return result;
   }
@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <fstream>
 #include <set>
+#include <algorithm>
+#include <cstring>
 
 #define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
 #define GLFW_INCLUDE_VULKAN
@@ -64,12 +66,20 @@ bool Tools::checkValidationLayerSupport() const
   return true;
 }
 
-std::vector<const char*> Tools::getRequiredExtensions(bool enableValidationLayers) const
+std::vector<const char*> Tools::getRequiredExtensions(bool enableValidationLayers, bool headless /* = false */) const
 {
-  uint32_t glfwExtensionCount{ 0 };
-  const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+  std::vector<const char*> extensions;
 
-  std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  if (headless) {
+    // GLFW is never initialized without a window, so ask for the surface extensions directly
+    extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+    extensions.push_back(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+  }
+  else {
+    uint32_t glfwExtensionCount{ 0 };
+    const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers)
   {
@@ -91,3 +101,12 @@ bool Tools::checkDeviceExtensionSupport(VkPhysicalDevice device) const
 
   return requiredExtensions.empty();
 }
+
+bool Tools::isDeviceExtensionSupported(VkPhysicalDevice device, const char* extensionName) const
+{
+  const auto availableExtensions = enumerate<VkExtensionProperties, VkPhysicalDevice>(device);
+
+  return std::any_of(availableExtensions.begin(), availableExtensions.end(), [extensionName](const auto& extension) {
+    return strcmp(extension.extensionName, extensionName) == 0;
+  });
+}
@@ -12,7 +12,8 @@ public:
   std::vector<char> readFile(const std::string& filename) const;
   bool checkValidationLayerSupport() const;
   bool checkDeviceExtensionSupport(VkPhysicalDevice device) const;
-  std::vector<const char*> getRequiredExtensions(bool enableValidationLayers) const;
+  bool isDeviceExtensionSupported(VkPhysicalDevice device, const char* extensionName) const;
+  std::vector<const char*> getRequiredExtensions(bool enableValidationLayers, bool headless = false) const;
 
 private:
   // Returns the path to the root of the shader directory.
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFORM_STORE_SSE
+#include <emmintrin.h>
+#endif
+
+#include "TransformStore.h"
+#include "JobSystem.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+  // below this many objects handing out jobs costs more than it saves
+  constexpr size_t PARALLEL_THRESHOLD = 4096;
+
+#ifdef TRANSFORM_STORE_SSE
+  // sine and cosine of four angles: reduced to [-pi, pi], folded into [-pi/2, pi/2] and evaluated with
+  // Taylor polynomials of degree 9 and 10 (error below 4e-6 on the folded range)
+  inline void sinCos(__m128 x, __m128& sine, __m128& cosine)
+  {
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 pi = _mm_set1_ps(3.14159265f);
+    const __m128 halfPi = _mm_set1_ps(1.57079633f);
+
+    // x - 2pi * round(x / 2pi), rounding to nearest under the default MXCSR; 2pi is split in two (Cody-Waite)
+    // so that turns * 6.28125 is exact and large angles keep their precision
+    const __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.159154943f))));
+    x = _mm_sub_ps(x, _mm_mul_ps(turns, _mm_set1_ps(6.28125f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(turns, _mm_set1_ps(1.93530717e-3f)));
+
+    // |x| > pi/2: sin(x) = sin(sign(x) * (pi - |x|)), cos(x) = -cos(sign(x) * (pi - |x|))
+    const __m128 sign = _mm_and_ps(x, signMask);
+    const __m128 absX = _mm_andnot_ps(signMask, x);
+    const __m128 folded = _mm_cmpgt_ps(absX, halfPi);
+    const __m128 reflected = _mm_xor_ps(_mm_sub_ps(pi, absX), sign); // pi - |x| dips below 0 when rounding leaves |x| just past pi
+    x = _mm_or_ps(_mm_and_ps(folded, reflected), _mm_andnot_ps(folded, x));
+
+    const __m128 x2 = _mm_mul_ps(x, x);
+
+    __m128 s = _mm_set1_ps(1.0f / 362880.0f);
+    s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.0f / 5040.0f));
+    s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(1.0f / 120.0f));
+    s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.0f / 6.0f));
+    s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(1.0f));
+    sine = _mm_mul_ps(s, x);
+
+    __m128 c = _mm_set1_ps(-1.0f / 3628800.0f);
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(1.0f / 40320.0f));
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-1.0f / 720.0f));
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(1.0f / 24.0f));
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-0.5f));
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(1.0f));
+    cosine = _mm_xor_ps(c, _mm_and_ps(folded, signMask));
+  }
+#endif
+}
+
+TransformStore::TransformStore()
+  : m_x{}
+  , m_y{}
+  , m_z{}
+  , m_angle{}
+  , m_angularVelocity{}
+  , m_scale{}
+  , m_color{}
+  , m_count{ 0 }
+{}
+
+void TransformStore::resize(size_t count)
+{
+  m_count = count;
+  m_x.assign(count, 0.0f);
+  m_y.assign(count, 0.0f);
+  m_z.assign(count, 0.0f);
+  m_angle.assign(count, 0.0f);
+  m_angularVelocity.assign(count, 0.0f);
+  m_scale.assign(count, 1.0f);
+  m_color.assign(count, glm::vec4(1.0f));
+}
+
+size_t TransformStore::size() const
+{
+  return m_count;
+}
+
+void TransformStore::set(size_t index, const glm::vec3& position, float angle, float angularVelocity, float scale, const glm::vec4& color)
+{
+  m_x[index] = position.x;
+  m_y[index] = position.y;
+  m_z[index] = position.z;
+  m_angle[index] = angle;
+  m_angularVelocity[index] = angularVelocity;
+  m_scale[index] = scale;
+  m_color[index] = color;
+}
+
+void TransformStore::build(float time, Instance* out)
+{
+  JobSystem& jobs = JobSystem::instance();
+  if (m_count < PARALLEL_THRESHOLD) {
+    buildSimd(time, out, 0, m_count);
+    return;
+  }
+
+  // one part per worker plus the caller; parts are multiples of 4 objects so only the last one has a scalar tail
+  const uint32_t partCount = jobs.workerCount() + 1;
+  jobs.parallelFor(partCount, [&](uint32_t part) {
+    const size_t first = m_count / 4 * part / partCount * 4;
+    const size_t last = part + 1 == partCount ? m_count : m_count / 4 * (part + 1) / partCount * 4;
+    buildSimd(time, out, first, last - first);
+  });
+}
+
+// reference path: what the renderer did per object with glm
+void TransformStore::buildScalar(float time, Instance* out, size_t first, size_t count) const
+{
+  for (size_t i = first; i < first + count; ++i) {
+    const glm::mat4 translation = glm::translate(glm::mat4(1.0f), glm::vec3(m_x[i], m_y[i], m_z[i]));
+    const glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), m_angle[i] + m_angularVelocity[i] * time, glm::vec3(0.0f, 0.0f, 1.0f));
+    const glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(m_scale[i]));
+
+    out[i].model = translation * rotation * scale;
+    out[i].color = m_color[i];
+  }
+}
+
+void TransformStore::buildSimd(float time, Instance* out, size_t first, size_t count) const
+{
+#ifdef TRANSFORM_STORE_SSE
+  const size_t last = first + count;
+  const __m128 t = _mm_set1_ps(time);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  // mapped instance memory is usually write-combined: stream whole vectors past the cache when we can
+  const bool aligned = (reinterpret_cast<uintptr_t>(out) % 16) == 0;
+  const auto store = [aligned](Instance& instance, const __m128 (&columns)[4], __m128 color) {
+    float* dst = reinterpret_cast<float*>(&instance);
+    if (aligned) {
+      _mm_stream_ps(dst + 0, columns[0]);
+      _mm_stream_ps(dst + 4, columns[1]);
+      _mm_stream_ps(dst + 8, columns[2]);
+      _mm_stream_ps(dst + 12, columns[3]);
+      _mm_stream_ps(dst + 16, color);
+    }
+    else {
+      _mm_storeu_ps(dst + 0, columns[0]);
+      _mm_storeu_ps(dst + 4, columns[1]);
+      _mm_storeu_ps(dst + 8, columns[2]);
+      _mm_storeu_ps(dst + 12, columns[3]);
+      _mm_storeu_ps(dst + 16, color);
+    }
+  };
+
+  size_t i = first;
+  for (; i + 4 <= last; i += 4) {
+    const __m128 angle = _mm_add_ps(_mm_loadu_ps(&m_angle[i]), _mm_mul_ps(_mm_loadu_ps(&m_angularVelocity[i]), t));
+    const __m128 scale = _mm_loadu_ps(&m_scale[i]);
+
+    __m128 sine, cosine;
+    sinCos(angle, sine, cosine);
+    const __m128 c = _mm_mul_ps(cosine, scale);
+    const __m128 s = _mm_mul_ps(sine, scale);
+
+    // rows of four objects, transposed into each object's columns:
+    // (c, s, 0, 0) (-s, c, 0, 0) (0, 0, scale, 0) (x, y, z, 1)
+    __m128 col0[4] = { c, s, zero, zero };
+    __m128 col1[4] = { _mm_sub_ps(zero, s), c, zero, zero };
+    __m128 col2[4] = { zero, zero, scale, zero };
+    __m128 col3[4] = { _mm_loadu_ps(&m_x[i]), _mm_loadu_ps(&m_y[i]), _mm_loadu_ps(&m_z[i]), one };
+    _MM_TRANSPOSE4_PS(col0[0], col0[1], col0[2], col0[3]);
+    _MM_TRANSPOSE4_PS(col1[0], col1[1], col1[2], col1[3]);
+    _MM_TRANSPOSE4_PS(col2[0], col2[1], col2[2], col2[3]);
+    _MM_TRANSPOSE4_PS(col3[0], col3[1], col3[2], col3[3]);
+
+    for (uint32_t k = 0; k < 4; ++k) {
+      const __m128 columns[4] = { col0[k], col1[k], col2[k], col3[k] };
+      store(out[i + k], columns, _mm_loadu_ps(&m_color[i + k].x));
+    }
+  }
+
+  if (aligned) {
+    _mm_sfence(); // streamed stores are weakly ordered, publish them before the submit
+  }
+
+  buildScalar(time, out, i, last - i);
+#else
+  buildScalar(time, out, first, count);
+#endif
+}
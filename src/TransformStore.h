@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp> // GLM_FORCE_* come from the build, see CMakeLists.txt
+
+// Per-object transforms in structure-of-arrays form (position, rotation about z, scale) and a batch kernel that turns
+// them into per-instance model matrices, written straight into mapped instance memory.
+// The rotation of object i at time t is angle[i] + angularVelocity[i] * t. The SSE kernel evaluates four objects per
+// iteration, including their sine/cosine; build() additionally splits the objects over the JobSystem workers.
+class TransformStore
+{
+public:
+  // one entry of the instance stream the kernel writes
+  struct Instance
+  {
+    glm::mat4 model;
+    glm::vec4 color;
+  };
+
+  TransformStore();
+
+  void resize(size_t count);
+  size_t size() const;
+
+  void set(size_t index, const glm::vec3& position, float angle, float angularVelocity, float scale, const glm::vec4& color);
+
+  // all objects, as jobs with the calling thread helping
+  void build(float time, Instance* out);
+
+  // [first, first + count) on the calling thread; build() uses the SIMD one
+  void buildScalar(float time, Instance* out, size_t first, size_t count) const;
+  void buildSimd(float time, Instance* out, size_t first, size_t count) const;
+
+private:
+  // SoA, one entry per object
+  std::vector<float> m_x;
+  std::vector<float> m_y;
+  std::vector<float> m_z;
+  std::vector<float> m_angle;
+  std::vector<float> m_angularVelocity;
+  std::vector<float> m_scale;
+  std::vector<glm::vec4> m_color;
+  size_t m_count;
+};
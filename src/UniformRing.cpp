@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <stdexcept>
+
+#define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "UniformRing.h"
+
+#include "ErrorHandling.hpp"
+
+UniformRing::UniformRing()
+  : m_device{ VK_NULL_HANDLE }
+  , m_allocator{ nullptr }
+  , m_buffer{ VK_NULL_HANDLE }
+  , m_memory{}
+  , m_alignment{ 1 }
+  , m_frameCapacity{ 0 }
+  , m_frame{ 0 }
+  , m_head{ 0 }
+{}
+
+void UniformRing::create(
+  VkDevice device,
+  MemoryAllocator& allocator,
+  VkPhysicalDevice physicalDevice,
+  uint32_t frameCount,
+  const std::vector<uint32_t>& queueFamilies /* = {} */,
+  VkDeviceSize frameCapacity /* = DEFAULT_FRAME_CAPACITY */
+)
+{
+  m_device = device;
+  m_allocator = &allocator;
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  m_alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+  m_frameCapacity = align(frameCapacity);
+
+  const bool concurrent = queueFamilies.size() > 1;
+
+  const VkBufferCreateInfo bufferInfo {
+    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+    .size = m_frameCapacity * frameCount,
+    .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+    .sharingMode = concurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+    .queueFamilyIndexCount = concurrent ? static_cast<uint32_t>(queueFamilies.size()) : 0u,
+    .pQueueFamilyIndices = concurrent ? queueFamilies.data() : nullptr
+  };
+
+  RESULT_HANDLER(vkCreateBuffer(m_device, &bufferInfo, nullptr, &m_buffer), "vkCreateBuffer");
+
+  VkMemoryRequirements memRequirements{};
+  vkGetBufferMemoryRequirements(m_device, m_buffer, &memRequirements);
+
+  m_memory = m_allocator->allocate(memRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+  RESULT_HANDLER(vkBindBufferMemory(m_device, m_buffer, m_memory.memory, m_memory.offset), "vkBindBufferMemory");
+}
+
+void UniformRing::cleanup()
+{
+  vkDestroyBuffer(m_device, m_buffer, nullptr);
+  m_buffer = VK_NULL_HANDLE;
+
+  if (m_allocator) {
+    m_allocator->free(m_memory);
+    m_memory = {};
+  }
+}
+
+VkDeviceSize UniformRing::align(VkDeviceSize size) const
+{
+  return (size + m_alignment - 1) / m_alignment * m_alignment;
+}
+
+void UniformRing::beginFrame(uint32_t frame)
+{
+  m_frame = frame;
+  m_head = 0;
+}
+
+UniformRing::Slice UniformRing::allocate(VkDeviceSize size)
+{
+  const VkDeviceSize alignedSize = align(size);
+  if (m_head + alignedSize > m_frameCapacity) {
+    throw std::runtime_error("uniform ring: per-frame capacity exhausted");
+  }
+
+  const VkDeviceSize offset = frameOffset(m_frame) + m_head;
+  m_head += alignedSize;
+
+  return {
+    .offset = static_cast<uint32_t>(offset),
+    .data = static_cast<char*>(m_memory.mapped) + offset
+  };
+}
+
+uint32_t UniformRing::frameOffset(uint32_t frame) const
+{
+  return static_cast<uint32_t>(m_frameCapacity * frame);
+}
+
+VkDescriptorBufferInfo UniformRing::descriptorBufferInfo(VkDeviceSize range) const
+{
+  return {
+    .buffer = m_buffer,
+    .offset = 0,
+    .range = range // the window the dynamic offset moves around
+  };
+}
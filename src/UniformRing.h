@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "MemoryAllocator.h"
+
+// One persistently mapped uniform buffer split into a segment per frame in flight.
+// Per-frame data is bump-allocated from the frame's segment and bound through a single
+// VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptor, so neither map/unmap nor extra descriptor sets are needed per frame.
+class UniformRing
+{
+public:
+  static constexpr VkDeviceSize DEFAULT_FRAME_CAPACITY = 64 * 1024;
+
+  struct Slice
+  {
+    uint32_t offset; // dynamic offset to bind with
+    void* data;
+  };
+
+  UniformRing();
+
+  // more than one queue family (async compute reading it too) shares the buffer concurrently
+  void create(
+    VkDevice device,
+    MemoryAllocator& allocator,
+    VkPhysicalDevice physicalDevice,
+    uint32_t frameCount,
+    const std::vector<uint32_t>& queueFamilies = {},
+    VkDeviceSize frameCapacity = DEFAULT_FRAME_CAPACITY
+  );
+  void cleanup();
+
+  // the frame's previous submission has to be complete
+  void beginFrame(uint32_t frame);
+  Slice allocate(VkDeviceSize size);
+
+  // the first allocation of a frame always lands here, which is what pre-recorded command buffers bind
+  uint32_t frameOffset(uint32_t frame) const;
+  VkDescriptorBufferInfo descriptorBufferInfo(VkDeviceSize range) const;
+
+private:
+  VkDeviceSize align(VkDeviceSize size) const;
+
+  VkDevice m_device;
+  MemoryAllocator* m_allocator;
+  VkBuffer m_buffer;
+  MemoryAllocator::Allocation m_memory;
+  VkDeviceSize m_alignment;     // minUniformBufferOffsetAlignment
+  VkDeviceSize m_frameCapacity; // segment size, a multiple of m_alignment
+  uint32_t m_frame;
+  VkDeviceSize m_head;          // next free byte within the current segment
+};
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "UploadManager.h"
+
+#include "ErrorHandling.hpp"
+
+namespace
+{
+  constexpr VkDeviceSize COPY_ALIGNMENT = 16; // covers optimalBufferCopyOffsetAlignment on every desktop driver
+}
+
+UploadManager::UploadManager()
+  : m_device{ VK_NULL_HANDLE }
+  , m_allocator{ nullptr }
+  , m_queue{ VK_NULL_HANDLE }
+  , m_queueFamilies{}
+  , m_useTimeline{ false }
+  , m_stagingBuffer{ VK_NULL_HANDLE }
+  , m_stagingMemory{}
+  , m_batches{}
+  , m_current{ 0 }
+  , m_ticket{ 0 }
+  , m_timeline{ VK_NULL_HANDLE }
+{}
+
+void UploadManager::create(VkDevice device, MemoryAllocator& allocator, uint32_t queueFamilyIndex, uint32_t graphicsFamilyIndex, bool useTimeline)
+{
+  m_device = device;
+  m_allocator = &allocator;
+  m_useTimeline = useTimeline;
+
+  m_queueFamilies = { queueFamilyIndex };
+  if (graphicsFamilyIndex != queueFamilyIndex) {
+    m_queueFamilies.push_back(graphicsFamilyIndex);
+  }
+
+  vkGetDeviceQueue(m_device, queueFamilyIndex, 0, &m_queue);
+
+  const VkBufferCreateInfo bufferInfo {
+    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+    .size = SEGMENT_SIZE * BATCH_COUNT,
+    .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+    .sharingMode = VK_SHARING_MODE_EXCLUSIVE
+  };
+
+  RESULT_HANDLER(vkCreateBuffer(m_device, &bufferInfo, nullptr, &m_stagingBuffer), "vkCreateBuffer");
+
+  VkMemoryRequirements memRequirements{};
+  vkGetBufferMemoryRequirements(m_device, m_stagingBuffer, &memRequirements);
+
+  m_stagingMemory = m_allocator->allocate(memRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+  RESULT_HANDLER(vkBindBufferMemory(m_device, m_stagingBuffer, m_stagingMemory.memory, m_stagingMemory.offset), "vkBindBufferMemory");
+
+  const VkCommandPoolCreateInfo poolInfo {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+    .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+    .queueFamilyIndex = queueFamilyIndex
+  };
+
+  static constexpr VkFenceCreateInfo fenceInfo {
+    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+  };
+
+  for (auto& batch : m_batches) {
+    batch = {};
+
+    RESULT_HANDLER(vkCreateCommandPool(m_device, &poolInfo, nullptr, &batch.commandPool), "vkCreateCommandPool");
+
+    const VkCommandBufferAllocateInfo allocInfo {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = batch.commandPool,
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1
+    };
+
+    RESULT_HANDLER(vkAllocateCommandBuffers(m_device, &allocInfo, &batch.commandBuffer), "vkAllocateCommandBuffers");
+
+    if (!m_useTimeline) {
+      RESULT_HANDLER(vkCreateFence(m_device, &fenceInfo, nullptr, &batch.fence), "vkCreateFence");
+    }
+  }
+
+  if (m_useTimeline) {
+    static const VkSemaphoreTypeCreateInfo timelineInfo {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+      .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+      .initialValue = 0
+    };
+
+    static const VkSemaphoreCreateInfo semaphoreInfo {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+      .pNext = &timelineInfo
+    };
+
+    RESULT_HANDLER(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_timeline), "vkCreateSemaphore");
+  }
+}
+
+void UploadManager::cleanup()
+{
+  if (!m_device) {
+    return;
+  }
+
+  flush();
+  wait(m_ticket);
+
+  for (auto& batch : m_batches) {
+    vkDestroyFence(m_device, batch.fence, nullptr);
+    vkDestroyCommandPool(m_device, batch.commandPool, nullptr);
+    batch = {};
+  }
+
+  vkDestroySemaphore(m_device, m_timeline, nullptr);
+  m_timeline = VK_NULL_HANDLE;
+
+  vkDestroyBuffer(m_device, m_stagingBuffer, nullptr);
+  m_allocator->free(m_stagingMemory);
+  m_stagingBuffer = VK_NULL_HANDLE;
+  m_stagingMemory = {};
+
+  m_device = VK_NULL_HANDLE;
+}
+
+// reuses the next batch slot once its previous submission, and with it the staging segment, is done
+void UploadManager::beginBatch()
+{
+  Batch& batch = m_batches[m_current];
+
+  if (batch.ticket) {
+    wait(batch.ticket);
+    if (!m_useTimeline) {
+      RESULT_HANDLER(vkResetFences(m_device, 1, &batch.fence), "vkResetFences");
+    }
+  }
+
+  RESULT_HANDLER(vkResetCommandPool(m_device, batch.commandPool, 0), "vkResetCommandPool");
+
+  static constexpr VkCommandBufferBeginInfo beginInfo {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+  };
+
+  RESULT_HANDLER(vkBeginCommandBuffer(batch.commandBuffer, &beginInfo), "vkBeginCommandBuffer");
+
+  batch.head = 0;
+  batch.recording = true;
+}
+
+void UploadManager::upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+{
+  const char* src = static_cast<const char*>(data);
+
+  // larger than what is left in the segment: split it across batches
+  while (size) {
+    if (!m_batches[m_current].recording) {
+      beginBatch();
+    }
+
+    Batch& batch = m_batches[m_current];
+    const VkDeviceSize chunk = std::min(size, SEGMENT_SIZE - batch.head);
+    if (chunk == 0) {
+      flush();
+      continue;
+    }
+
+    const VkDeviceSize stagingOffset = m_current * SEGMENT_SIZE + batch.head;
+    std::memcpy(static_cast<char*>(m_stagingMemory.mapped) + stagingOffset, src, chunk);
+
+    const VkBufferCopy copyRegion {
+      .srcOffset = stagingOffset,
+      .dstOffset = dstOffset,
+      .size = chunk
+    };
+    vkCmdCopyBuffer(batch.commandBuffer, m_stagingBuffer, dstBuffer, 1, &copyRegion);
+
+    batch.head = std::min(SEGMENT_SIZE, (batch.head + chunk + COPY_ALIGNMENT - 1) / COPY_ALIGNMENT * COPY_ALIGNMENT);
+    src += chunk;
+    dstOffset += chunk;
+    size -= chunk;
+  }
+}
+
+uint64_t UploadManager::flush()
+{
+  Batch& batch = m_batches[m_current];
+  if (!batch.recording) {
+    return m_ticket;
+  }
+
+  RESULT_HANDLER(vkEndCommandBuffer(batch.commandBuffer), "vkEndCommandBuffer");
+
+  const uint64_t ticket = m_ticket + 1;
+
+  const VkTimelineSemaphoreSubmitInfo timelineInfo {
+    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+    .signalSemaphoreValueCount = 1,
+    .pSignalSemaphoreValues = &ticket
+  };
+
+  const VkSubmitInfo submitInfo {
+    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    .pNext = m_useTimeline ? &timelineInfo : nullptr,
+    .commandBufferCount = 1,
+    .pCommandBuffers = &batch.commandBuffer,
+    .signalSemaphoreCount = m_useTimeline ? 1u : 0u,
+    .pSignalSemaphores = m_useTimeline ? &m_timeline : nullptr
+  };
+
+  RESULT_HANDLER(vkQueueSubmit(m_queue, 1, &submitInfo, batch.fence), "vkQueueSubmit");
+
+  batch.ticket = ticket;
+  batch.recording = false;
+  m_ticket = ticket;
+  m_current = (m_current + 1) % BATCH_COUNT;
+
+  return ticket;
+}
+
+bool UploadManager::isComplete(uint64_t ticket) const
+{
+  if (ticket == 0) {
+    return true;
+  }
+
+  if (m_useTimeline) {
+    uint64_t value{ 0 };
+    RESULT_HANDLER(vkGetSemaphoreCounterValue(m_device, m_timeline, &value), "vkGetSemaphoreCounterValue");
+    return value >= ticket;
+  }
+
+  // tickets go round the batch slots in order; a slot that moved on has finished this ticket
+  const Batch& batch = m_batches[(ticket - 1) % BATCH_COUNT];
+  return batch.ticket != ticket || vkGetFenceStatus(m_device, batch.fence) == VK_SUCCESS;
+}
+
+void UploadManager::wait(uint64_t ticket) const
+{
+  if (ticket == 0) {
+    return;
+  }
+
+  if (m_useTimeline) {
+    const VkSemaphoreWaitInfo waitInfo {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+      .semaphoreCount = 1,
+      .pSemaphores = &m_timeline,
+      .pValues = &ticket
+    };
+
+    RESULT_HANDLER(vkWaitSemaphores(m_device, &waitInfo, std::numeric_limits<uint64_t>::max()), "vkWaitSemaphores");
+    return;
+  }
+
+  const Batch& batch = m_batches[(ticket - 1) % BATCH_COUNT];
+  if (batch.ticket == ticket) {
+    RESULT_HANDLER(vkWaitForFences(m_device, 1, &batch.fence, VK_TRUE, std::numeric_limits<uint64_t>::max()), "vkWaitForFences");
+  }
+}
+
+uint64_t UploadManager::lastTicket() const
+{
+  return m_ticket;
+}
+
+VkSemaphore UploadManager::timelineSemaphore() const
+{
+  return m_timeline;
+}
+
+const std::vector<uint32_t>& UploadManager::queueFamilies() const
+{
+  return m_queueFamilies;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "MemoryAllocator.h"
+
+// Buffer uploads through a persistently mapped staging ring, submitted on the transfer queue.
+// The ring is split into one segment per batch; upload() copies into the open batch's segment and records
+// a vkCmdCopyBuffer, flush() submits the batch and returns its ticket. Completion is tracked with a timeline
+// semaphore (or a fence per batch), never by idling a queue. Not thread safe: call from one thread at a time.
+class UploadManager
+{
+public:
+  static constexpr uint32_t BATCH_COUNT = 4;
+  static constexpr VkDeviceSize SEGMENT_SIZE = 4ull << 20;
+
+  UploadManager();
+
+  void create(VkDevice device, MemoryAllocator& allocator, uint32_t queueFamilyIndex, uint32_t graphicsFamilyIndex, bool useTimeline);
+  void cleanup();
+
+  void upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+  uint64_t flush();
+
+  bool isComplete(uint64_t ticket) const;
+  void wait(uint64_t ticket) const;
+  uint64_t lastTicket() const;
+
+  // for consumers on the graphics queue: wait on timelineSemaphore() >= lastTicket() (timeline path),
+  // or call wait(lastTicket()) before the first use (fence path)
+  VkSemaphore timelineSemaphore() const;
+
+  // buffers written by the transfer queue and read by the graphics queue are shared between these
+  const std::vector<uint32_t>& queueFamilies() const;
+
+private:
+  struct Batch
+  {
+    VkCommandPool commandPool;
+    VkCommandBuffer commandBuffer;
+    VkFence fence;        // fence path only
+    uint64_t ticket;      // 0 = never submitted
+    VkDeviceSize head;    // bytes used in this batch's staging segment
+    bool recording;
+  };
+
+  void beginBatch();
+
+  VkDevice m_device;
+  MemoryAllocator* m_allocator;
+  VkQueue m_queue;
+  std::vector<uint32_t> m_queueFamilies;
+  bool m_useTimeline;
+
+  VkBuffer m_stagingBuffer;
+  MemoryAllocator::Allocation m_stagingMemory;
+
+  std::array<Batch, BATCH_COUNT> m_batches;
+  uint32_t m_current; // batch receiving upload() calls
+  uint64_t m_ticket;  // last submitted ticket
+
+  VkSemaphore m_timeline; // signaled to the batch ticket on completion
+};
@@ -1,9 +1,12 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <stdexcept>
 #include <vector>
 #include <iostream>
-#include <mutex>
 
 #include "VertexBuffer.h"
+#include "MeshFile.h"
 #include "Settings.hpp"
 
 #include "ErrorHandling.hpp"
@@ -33,130 +36,203 @@ const std::vector<uint16_t> indices = {
     0, 1, 2, // 2, 3, 0
 };
 
-std::atomic<bool> rotate = true;
-std::atomic<float> spin_angle = 45.0f;
-std::atomic<float> spin_increment = 1.0f;
-
-void VertexBuffer::rotateRight()
+void VertexBuffer::beginFrame(InputQueue& input)
 {
-  spin_angle += spin_increment;
+  InputEvent event;
+  while (input.pop(event)) {
+    switch (event.type) {
+      case InputEvent::Type::RotateRight:
+        m_spinAngle += m_spinIncrement;
+        break;
+      case InputEvent::Type::RotateLeft:
+        m_spinAngle -= m_spinIncrement;
+        break;
+      case InputEvent::Type::RotateToggle:
+        m_rotate = !m_rotate;
+        if (m_rotate) {
+          m_rotateTimer.Start(event.time);
+        }
+        else {
+          m_rotateTimer.Stop(event.time);
+        }
+        break;
+    }
+  }
+
+  m_frameTime = std::chrono::duration<float, std::chrono::seconds::period>(m_rotateTimer.GetElapsed()).count();
 }
 
-void VertexBuffer::rotateLeft()
+void VertexBuffer::enableCulling(VkPipelineCache pipelineCache)
 {
-  spin_angle -= spin_increment;
+  m_culler.create(
+    m_device,
+    *m_allocator,
+    pipelineCache,
+    MAX_FRAMES_IN_FLIGHT,
+    descriptorBufferInfo(),
+    m_instanceBuffer,
+    m_instanceFrameStride,
+    static_cast<uint32_t>(m_transforms.size()),
+    sizeof(Instance),
+    m_indexCount,
+    m_boundingRadius
+  );
+
+  if (m_computeQueue != VK_NULL_HANDLE) {
+    std::vector<uint32_t> uniformOffsets;
+    for (uint32_t frameSlot = 0; frameSlot < MAX_FRAMES_IN_FLIGHT; ++frameSlot) {
+      uniformOffsets.push_back(m_uniformRing.frameOffset(frameSlot));
+    }
+    m_culler.useAsyncCompute(m_computeQueue, m_computeFamily, m_graphicsFamily, uniformOffsets);
+  }
 }
 
-void VertexBuffer::rotateToggle()
+void VertexBuffer::setAsyncCompute(VkQueue computeQueue, uint32_t computeFamily, uint32_t graphicsFamily)
 {
-  rotate = !rotate;
-  
-  std::scoped_lock lock(m_rotateTimerMutex);
+  m_computeQueue = computeQueue;
+  m_computeFamily = computeFamily;
+  m_graphicsFamily = graphicsFamily;
+}
 
-  if (!m_rotateTimer) {
-    return;
+void VertexBuffer::submitCulling(uint32_t frameSlot) const
+{
+  if (m_culler.async()) {
+    m_culler.submit(frameSlot);
   }
+}
 
-  if (rotate) {
-    m_rotateTimer->Start();
-  }
-  else {
-    m_rotateTimer->Stop();
-  }
+VkSemaphore VertexBuffer::cullingSemaphore(uint32_t frameSlot) const
+{
+  return m_culler.enabled() ? m_culler.semaphore(frameSlot) : VK_NULL_HANDLE;
 }
 
-uint32_t VertexBuffer::findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+void VertexBuffer::setInstancesPerDraw(uint32_t instancesPerDraw)
 {
-  VkPhysicalDeviceMemoryProperties memProperties;
-  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+  m_instancesPerDraw = instancesPerDraw;
+}
 
-  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) 
-  {
-    if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) 
-    {
-      return i;
-    }
+uint32_t VertexBuffer::drawCount() const
+{
+  if (m_culler.enabled()) {
+    return 1; // the indirect draw
   }
 
-  throw std::runtime_error("failed to find suitable memory type!");
+  const uint32_t instanceCount = static_cast<uint32_t>(m_transforms.size());
+  if (m_instancesPerDraw == 0 || m_instancesPerDraw >= instanceCount) {
+    return 1;
+  }
+  return (instanceCount + m_instancesPerDraw - 1) / m_instancesPerDraw;
 }
 
-VkCommandBuffer VertexBuffer::beginSingleTimeCommands() const
+void VertexBuffer::setPushConstants(bool enabled)
 {
-  const VkCommandBufferAllocateInfo allocInfo {
-    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-    .commandPool = m_commandPool,
-    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-    .commandBufferCount = 1
-  };
-
-  VkCommandBuffer commandBuffer;
-  vkAllocateCommandBuffers(m_device, &allocInfo, &commandBuffer);
+  m_pushConstants = enabled;
+}
 
-  const VkCommandBufferBeginInfo beginInfo {
-    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+VkPushConstantRange VertexBuffer::pushConstantRange()
+{
+  return {
+    .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+    .offset = 0,
+    .size = sizeof(glm::mat4)
   };
+}
+
+void VertexBuffer::create(VkDevice device, VkPhysicalDevice physicalDevice, MemoryAllocator& allocator, UploadManager& uploads, const std::string& meshPath, uint32_t instanceCount)
+{
+  m_device = device;
+  m_physicalDevice = physicalDevice;
+  m_allocator = &allocator;
+  m_model = glm::mat4(1.0f);
+  m_uniformExtents.assign(MAX_FRAMES_IN_FLIGHT, VkExtent2D{ 0, 0 });
+  m_uploads = &uploads;
+  createGeometry(meshPath);
+  createInstanceBuffer(instanceCount);
+  createUniformBuffers();
 
-  vkBeginCommandBuffer(commandBuffer, &beginInfo);
+  // one batch for all of them; the graphics queue waits for it before the first draw
+  m_uploads->flush();
 
-  return commandBuffer;
+  m_rotateTimer.Start();
 }
 
-void VertexBuffer::endSingleTimeCommands(VkCommandBuffer commandBuffer) const
+void VertexBuffer::createGeometry(const std::string& meshPath)
 {
-  vkEndCommandBuffer(commandBuffer);
+  if (meshPath.empty()) {
+    m_bindingDescriptions = Vertex::getBindingDescription();
+    m_attributeDescriptions = Vertex::getAttributeDescriptions();
+    m_indexType = VK_INDEX_TYPE_UINT16;
+    m_indexCount = static_cast<uint32_t>(indices.size());
+    m_boundingRadius = 0.0f;
+    for (const auto& vertex : vertices) {
+      m_boundingRadius = std::max(m_boundingRadius, glm::length(vertex.pos));
+    }
+    createVertexBuffer(vertices.data(), sizeof(vertices[0]) * vertices.size());
+    createIndexBuffer(indices.data(), sizeof(indices[0]) * indices.size());
+    return;
+  }
 
-  const VkSubmitInfo submitInfo {
-    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-    .commandBufferCount = 1,
-    .pCommandBuffers = &commandBuffer,
-  };
+  // the blobs go from the mapping straight into staging memory; the mapping is released on return,
+  // which is fine since upload() has copied them by then
+  const MeshFile mesh(meshPath);
+  const MeshFormat::Header& header = mesh.header();
 
-  vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(m_graphicsQueue);
+  if (header.indexCount > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error(meshPath + ": too many indices");
+  }
 
-  vkFreeCommandBuffers(m_device, m_commandPool, 1, &commandBuffer);
+  m_bindingDescriptions = { {
+    .binding = 0,
+    .stride = header.vertexStride,
+    .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+  } };
+
+  m_attributeDescriptions.clear();
+  bool hasPosition = false;
+  bool hasColor = false;
+  for (uint32_t i = 0; i < header.attributeCount; ++i) {
+    const MeshFormat::VertexAttribute& attribute = header.attributes[i];
+    m_attributeDescriptions.push_back({
+      .location = attribute.location,
+      .binding = 0,
+      .format = attribute.format == MeshFormat::AttributeFormat::Float2 ? VK_FORMAT_R32G32_SFLOAT
+              : attribute.format == MeshFormat::AttributeFormat::Float3 ? VK_FORMAT_R32G32B32_SFLOAT
+              : VK_FORMAT_R32G32B32A32_SFLOAT,
+      .offset = attribute.offset
+    });
+    hasPosition |= attribute.location == 0;
+    hasColor |= attribute.location == 1 && attribute.format != MeshFormat::AttributeFormat::Float2;
+  }
+
+  // the shaders read a position at location 0 and an rgb colour at location 1
+  if (!hasPosition || !hasColor) {
+    throw std::runtime_error(meshPath + ": vertex layout lacks a position or colour attribute");
+  }
+
+  // the culling sphere comes from the converter, the blobs are not read on the CPU
+  m_boundingRadius = header.boundingRadius;
+
+  m_indexType = header.indexSize == 4 ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+  m_indexCount = static_cast<uint32_t>(header.indexCount);
+
+  createVertexBuffer(mesh.vertexData(), mesh.vertexDataSize());
+  createIndexBuffer(mesh.indexData(), mesh.indexDataSize());
+
+  logger << "mesh: " << meshPath << ", " << header.vertexCount << " vertices, " << header.indexCount << " indices" << std::endl;
 }
 
-void VertexBuffer::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) const
+const std::vector<VkVertexInputBindingDescription>& VertexBuffer::bindingDescriptions() const
 {
-  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-    VkBufferCopy copyRegion {  .size = size  };
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-  endSingleTimeCommands(commandBuffer);
+  return m_bindingDescriptions;
 }
 
-void VertexBuffer::create(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool)
+const std::vector<VkVertexInputAttributeDescription>& VertexBuffer::attributeDescriptions() const
 {
-  m_device = device;
-  m_physicalDevice = physicalDevice;
-  m_graphicsQueue = graphicsQueue;
-  m_commandPool = commandPool;
-  createVertexBuffer();
-  createIndexBuffer();
-  createUniformBuffers();
+  return m_attributeDescriptions;
 }
 
-void VertexBuffer::createVertexBuffer()
+void VertexBuffer::createVertexBuffer(const void* data, VkDeviceSize bufferSize)
 {
-  const VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-
-  VkBuffer stagingBuffer;
-  VkDeviceMemory stagingBufferMemory;
-
-  createBuffer(
-    bufferSize, 
-    VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-    stagingBuffer, stagingBufferMemory
-  );
-
-  void* data;
-  vkMapMemory(m_device, stagingBufferMemory, 0, bufferSize, 0, &data);
-  memcpy(data, vertices.data(), (size_t)bufferSize);
-  vkUnmapMemory(m_device, stagingBufferMemory);
-
   createBuffer(
     bufferSize,
     VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
@@ -165,19 +241,22 @@ void VertexBuffer::createVertexBuffer()
     m_vertexBufferMemory
   );
 
-  copyBuffer(stagingBuffer, m_vertexBuffer, bufferSize);
-
-  vkDestroyBuffer(m_device, stagingBuffer, nullptr);
-  vkFreeMemory(m_device, stagingBufferMemory, nullptr);
+  m_uploads->upload(m_vertexBuffer, 0, data, bufferSize);
 }
 
-void VertexBuffer::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+void VertexBuffer::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocator::Allocation& bufferMemory)
 {
+  // written on the transfer queue, read on the graphics queue -- concurrent sharing saves the ownership transfer
+  const std::vector<uint32_t>& queueFamilies = m_uploads->queueFamilies();
+  const bool concurrent = (usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && queueFamilies.size() > 1;
+
   const VkBufferCreateInfo bufferInfo {
     .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
     .size = size,
     .usage = usage,
-    .sharingMode = VK_SHARING_MODE_EXCLUSIVE
+    .sharingMode = concurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+    .queueFamilyIndexCount = concurrent ? static_cast<uint32_t>(queueFamilies.size()) : 0u,
+    .pQueueFamilyIndices = concurrent ? queueFamilies.data() : nullptr
   };
 
   RESULT_HANDLER(vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer), "vkCreateBuffer");
@@ -185,37 +264,20 @@ void VertexBuffer::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkM
   VkMemoryRequirements memRequirements{};
   vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo {
-    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-    .allocationSize = memRequirements.size,
-    .memoryTypeIndex = findMemoryType(m_physicalDevice, memRequirements.memoryTypeBits, properties),
-  };
-
-  RESULT_HANDLER(vkAllocateMemory(m_device, &allocInfo, nullptr, &bufferMemory), "vkAllocateMemory");
+  // a sub-range of a shared block, see MemoryAllocator
+  bufferMemory = m_allocator->allocate(memRequirements, properties);
 
-  vkBindBufferMemory(m_device, buffer, bufferMemory, 0);
+  RESULT_HANDLER(vkBindBufferMemory(m_device, buffer, bufferMemory.memory, bufferMemory.offset), "vkBindBufferMemory");
 }
 
-void VertexBuffer::createIndexBuffer()
+void VertexBuffer::destroyBuffer(VkBuffer buffer, const MemoryAllocator::Allocation& bufferMemory)
 {
-  const VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
-
-  VkBuffer stagingBuffer;
-  VkDeviceMemory stagingBufferMemory;
-  
-  createBuffer(
-    bufferSize, 
-    VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-    stagingBuffer, 
-    stagingBufferMemory
-  );
-
-  void* data;
-  vkMapMemory(m_device, stagingBufferMemory, 0, bufferSize, 0, &data);
-  memcpy(data, indices.data(), (size_t)bufferSize);
-  vkUnmapMemory(m_device, stagingBufferMemory);
+  vkDestroyBuffer(m_device, buffer, nullptr);
+  m_allocator->free(bufferMemory);
+}
 
+void VertexBuffer::createIndexBuffer(const void* data, VkDeviceSize bufferSize)
+{
   createBuffer(
     bufferSize, 
     VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 
@@ -224,42 +286,69 @@ void VertexBuffer::createIndexBuffer()
     m_indexBufferMemory
   );
 
-  copyBuffer(stagingBuffer, m_indexBuffer, bufferSize);
-
-  vkDestroyBuffer(m_device, stagingBuffer, nullptr);
-  vkFreeMemory(m_device, stagingBufferMemory, nullptr);
+  m_uploads->upload(m_indexBuffer, 0, data, bufferSize);
 }
 
-void VertexBuffer::createUniformBuffers()
+// lays the instances out on a square grid filling the view, each one shrunk to its cell and spinning at its own rate;
+// a single instance is the untransformed mesh
+void VertexBuffer::createInstanceBuffer(uint32_t instanceCount)
 {
-  constexpr VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-  m_uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-  m_uniformBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
-
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    createBuffer(
-      bufferSize, 
-      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-      m_uniformBuffers[i], 
-      m_uniformBuffersMemory[i]
+  const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(instanceCount))));
+  const float cell = 2.4f / side;
+
+  m_transforms.resize(instanceCount);
+  for (uint32_t i = 0; i < instanceCount && side > 1; ++i) {
+    const uint32_t column = i % side;
+    const uint32_t row = i / side;
+
+    m_transforms.set(
+      i,
+      glm::vec3(-1.2f + (column + 0.5f) * cell, -1.2f + (row + 0.5f) * cell, 0.0f),
+      0.1f * i,
+      (i % 2 ? 1.0f : -1.0f) * (0.5f + 0.25f * (i % 7)),
+      0.45f * cell,
+      glm::vec4(0.5f + 0.5f * column / side, 0.5f + 0.5f * row / side, 1.0f, 1.0f)
     );
   }
+
+  // rewritten by the CPU every frame, so host visible; frames start 256-byte aligned for the culling pass's storage binding
+  m_instanceFrameStride = (sizeof(Instance) * instanceCount + 255) / 256 * 256;
+  const VkDeviceSize bufferSize = m_instanceFrameStride * MAX_FRAMES_IN_FLIGHT;
+
+  createBuffer(
+    bufferSize,
+    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, // read by the culling pass
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+    m_instanceBuffer,
+    m_instanceBufferMemory
+  );
+
+  for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; ++frame) {
+    m_transforms.build(0.0f, reinterpret_cast<TransformStore::Instance*>(static_cast<char*>(m_instanceBufferMemory.mapped) + frame * m_instanceFrameStride));
+  }
+
+  m_bindingDescriptions.push_back(Instance::getBindingDescription());
+  const auto instanceAttributes = Instance::getAttributeDescriptions();
+  m_attributeDescriptions.insert(m_attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
+
+  logger << "instances: " << instanceCount << " (" << bufferSize / 1024 << " KiB)" << std::endl;
 }
 
-void VertexBuffer::updateUniformBuffer(uint32_t currentImage, const VkExtent2D& swapChainExtent)
+// the frame slot's previous submission has to be complete
+void VertexBuffer::updateInstances(uint32_t frameSlot)
 {
-  static float time = 0.0f;
-  {
-    std::scoped_lock lock(m_rotateTimerMutex);
-    if (m_rotateTimer == nullptr) {
-      m_rotateTimer = std::make_unique<Timer>();
-      m_rotateTimer->Start();
-    }
-    time = std::chrono::duration<float, std::chrono::seconds::period>(m_rotateTimer->GetElapsed()).count();
-  }
+  m_transforms.build(m_frameTime, reinterpret_cast<TransformStore::Instance*>(static_cast<char*>(m_instanceBufferMemory.mapped) + frameSlot * m_instanceFrameStride));
+}
 
+void VertexBuffer::createUniformBuffers()
+{
+  // the culling pass reads view and proj on the compute queue
+  const std::vector<uint32_t> queueFamilies = m_computeQueue != VK_NULL_HANDLE ? std::vector<uint32_t>{ m_graphicsFamily, m_computeFamily } : std::vector<uint32_t>{};
+  m_uniformRing.create(m_device, *m_allocator, m_physicalDevice, MAX_FRAMES_IN_FLIGHT, queueFamilies);
+}
+
+void VertexBuffer::updateUniformBuffer(uint32_t frameSlot, const VkExtent2D& swapChainExtent)
+{
   static UniformBufferObject ubo {
     .model = glm::mat4(1.0f)
   };
@@ -287,43 +376,47 @@ void VertexBuffer::updateUniformBuffer(uint32_t currentImage, const VkExtent2D&
     glm::vec3(0.0f, 0.0f, -2.25f)
   );
   
-  if (rotate.load()) {
+  if (m_rotate) {
     ubo.model = glm::rotate(
       glm::mat4(1.0f),
       //ubo.model,
-      time * glm::radians(spin_angle.load()),
+      m_frameTime * glm::radians(m_spinAngle),
       glm::vec3(0.0f, 0.0f, 1.0f)
     );
   }
   ubo.proj[1][1] *= -1; // Flip projection matrix from GL to Vulkan orientation.
 
-  void* data;
-  vkMapMemory(m_device, m_uniformBuffersMemory[currentImage], 0, sizeof(ubo), 0, &data);
-  memcpy(data, &ubo, sizeof(ubo));
-  vkUnmapMemory(m_device, m_uniformBuffersMemory[currentImage]);
+  m_model = ubo.model;
+
+  m_uniformRing.beginFrame(frameSlot);
+  const UniformRing::Slice slice = m_uniformRing.allocate(sizeof(ubo));
+
+  // view is constant and proj only follows the extent, so on the push-constant path a slot is written once per size
+  VkExtent2D& writtenExtent = m_uniformExtents[frameSlot];
+  if (m_pushConstants && writtenExtent.width == swapChainExtent.width && writtenExtent.height == swapChainExtent.height) {
+    return;
+  }
+  writtenExtent = swapChainExtent;
+
+  memcpy(slice.data, &ubo, sizeof(ubo));
 }
 
-VkDescriptorBufferInfo VertexBuffer::descriptorBufferInfo(size_t index) const
+VkDescriptorBufferInfo VertexBuffer::descriptorBufferInfo() const
 {
-  return {
-    .buffer = m_uniformBuffers[index],
-    .offset = 0,
-    .range = sizeof(UniformBufferObject)
-  };
+  return m_uniformRing.descriptorBufferInfo(sizeof(UniformBufferObject));
 }
 
 void VertexBuffer::cleanup()
 {
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    vkDestroyBuffer(m_device, m_uniformBuffers[i], nullptr);
-    vkFreeMemory(m_device, m_uniformBuffersMemory[i], nullptr);
-  }
+  m_culler.cleanup();
+
+  m_uniformRing.cleanup();
 
-  vkDestroyBuffer(m_device, m_indexBuffer, nullptr);
-  vkFreeMemory(m_device, m_indexBufferMemory, nullptr);
+  destroyBuffer(m_instanceBuffer, m_instanceBufferMemory);
 
-  vkDestroyBuffer(m_device, m_vertexBuffer, nullptr);
-  vkFreeMemory(m_device, m_vertexBufferMemory, nullptr);
+  destroyBuffer(m_indexBuffer, m_indexBufferMemory);
+
+  destroyBuffer(m_vertexBuffer, m_vertexBufferMemory);
 }
 
 void VertexBuffer::renderPass(
@@ -331,36 +424,104 @@ void VertexBuffer::renderPass(
   const VkCommandBuffer &commandBuffer, 
   VkPipeline graphicsPipeline, 
   VkPipelineLayout pipelineLayout, 
-  const VkDescriptorSet *descriptorSet
+  const VkDescriptorSet *descriptorSet,
+  const GpuTimer &gpuTimer,
+  uint32_t frameSlot,
+  VkCommandBufferUsageFlags usage,
+  const std::vector<VkCommandBuffer>& secondaries /* = {} */
 )
 {
   const VkCommandBufferBeginInfo beginInfo {
     VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
     nullptr, // pNext
-    // same buffer can be re-executed before it finishes from last submit
-    VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT, // flags
+    usage, // flags
     nullptr // inheritance
   };
 
   RESULT_HANDLER(vkBeginCommandBuffer(commandBuffer, &beginInfo), "vkBeginCommandBuffer");
 
-  vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+  gpuTimer.cmdBegin(commandBuffer, frameSlot);
+
+  if (m_culler.async()) {
+    m_culler.recordAcquire(commandBuffer, frameSlot);
+  }
+  else if (m_culler.enabled() && graphicsPipeline != VK_NULL_HANDLE) {
+    m_culler.record(commandBuffer, frameSlot, m_uniformRing.frameOffset(frameSlot));
+  }
 
-      vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+  if (!secondaries.empty()) {
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+      vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+    vkCmdEndRenderPass(commandBuffer);
+  }
+  else {
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+      recordDraws(commandBuffer, renderPassInfo.renderArea, graphicsPipeline, pipelineLayout, descriptorSet, frameSlot, 0, drawCount());
+    vkCmdEndRenderPass(commandBuffer);
+  }
 
-      VkBuffer vertexBuffers[] = { m_vertexBuffer };
-      VkDeviceSize offsets[] = { 0 };
-      vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+  gpuTimer.cmdEnd(commandBuffer, frameSlot);
 
-      vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+  RESULT_HANDLER(vkEndCommandBuffer(commandBuffer), "vkEndCommandBuffer");
+}
 
-      vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, descriptorSet, 0, nullptr);
+void VertexBuffer::recordDraws(
+  VkCommandBuffer commandBuffer,
+  const VkRect2D& renderArea,
+  VkPipeline graphicsPipeline,
+  VkPipelineLayout pipelineLayout,
+  const VkDescriptorSet* descriptorSet,
+  uint32_t frameSlot,
+  uint32_t firstDraw,
+  uint32_t count
+) const
+{
+  // the pipeline may still be building, then the pass only clears
+  if (graphicsPipeline == VK_NULL_HANDLE || count == 0) {
+    return;
+  }
+
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 
-      vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+  // dynamic state -- the pipeline outlives swapchain resizes
+  const VkViewport viewport {
+    .x = static_cast<float>(renderArea.offset.x),
+    .y = static_cast<float>(renderArea.offset.y),
+    .width = static_cast<float>(renderArea.extent.width),
+    .height = static_cast<float>(renderArea.extent.height),
+    .minDepth = 0.0f,
+    .maxDepth = 1.0f
+  };
+  vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+  vkCmdSetScissor(commandBuffer, 0, 1, &renderArea);
 
-  vkCmdEndRenderPass(commandBuffer);
+  // culling path: the instance stream is the frame's compacted survivors
+  VkBuffer vertexBuffers[] = { m_vertexBuffer, m_culler.enabled() ? m_culler.visibleInstances(frameSlot) : m_instanceBuffer };
+  VkDeviceSize offsets[] = { 0, m_culler.enabled() ? 0 : frameSlot * m_instanceFrameStride };
+  vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
 
-  RESULT_HANDLER(vkEndCommandBuffer(commandBuffer), "vkEndCommandBuffer");
+  vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer, 0, m_indexType);
+
+  // the frame slot's uniforms are at the start of its ring segment
+  const uint32_t dynamicOffset = m_uniformRing.frameOffset(frameSlot);
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, descriptorSet, 1, &dynamicOffset);
+
+  if (m_pushConstants) {
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(m_model), &m_model);
+  }
+
+  if (m_culler.enabled()) {
+    vkCmdDrawIndexedIndirect(commandBuffer, m_culler.drawCommand(frameSlot), 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+    return;
+  }
+
+  const uint32_t instanceCount = static_cast<uint32_t>(m_transforms.size());
+  const uint32_t perDraw = m_instancesPerDraw ? m_instancesPerDraw : instanceCount;
+
+  for (uint32_t draw = firstDraw; draw < firstDraw + count; ++draw) {
+    const uint32_t firstInstance = draw * perDraw;
+    vkCmdDrawIndexed(commandBuffer, m_indexCount, std::min(perDraw, instanceCount - firstInstance), 0, 0, firstInstance);
+  }
 }
 
 std::vector<VkVertexInputBindingDescription> VertexBuffer::Vertex::getBindingDescription()
@@ -397,3 +558,29 @@ std::vector<VkVertexInputAttributeDescription> VertexBuffer::Vertex::getAttribut
       }*/
     } };
 }
+
+VkVertexInputBindingDescription VertexBuffer::Instance::getBindingDescription()
+{
+  return {
+    .binding = 1,
+    .stride = sizeof(VertexBuffer::Instance),
+    .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
+  };
+}
+
+std::vector<VkVertexInputAttributeDescription> VertexBuffer::Instance::getAttributeDescriptions()
+{
+  return { {
+    // a mat4 attribute takes one location per column
+    { .location = 2, .binding = 1, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = offsetof(TransformStore::Instance, model) },
+    { .location = 3, .binding = 1, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = offsetof(TransformStore::Instance, model) + sizeof(glm::vec4) },
+    { .location = 4, .binding = 1, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = offsetof(TransformStore::Instance, model) + 2 * sizeof(glm::vec4) },
+    { .location = 5, .binding = 1, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = offsetof(TransformStore::Instance, model) + 3 * sizeof(glm::vec4) },
+    {
+      .location = 6,
+      .binding = 1,
+      .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+      .offset = offsetof(TransformStore::Instance, color)
+    }
+  } };
+}
@@ -1,19 +1,25 @@
 #pragma once 
 
 #include <array>
+#include <string>
 
 #define GLFW_INCLUDE_NONE // Actually means include no OpenGL header
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
-#define GLM_FORCE_RADIANS
-#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
-#include <glm/glm.hpp>
+#include <glm/glm.hpp> // GLM_FORCE_* come from the build, see CMakeLists.txt
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <chrono>
 
 #include "Timer.hpp"
+#include "InputQueue.hpp"
+#include "GpuTimer.h"
+#include "MemoryAllocator.h"
+#include "UniformRing.h"
+#include "UploadManager.h"
+#include "GpuCuller.h"
+#include "TransformStore.h"
 
 class VertexBuffer
 {
@@ -35,49 +41,119 @@ public:
     static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
   };
 
-  void create(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool);
+  // per-instance stream on binding 1: model matrix (locations 2-5) and a colour multiplying the vertex colour (location 6),
+  // written every frame by TransformStore
+  struct Instance : TransformStore::Instance
+  {
+    static VkVertexInputBindingDescription getBindingDescription();
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+  };
+
+  // push-constant path: the model matrix is pushed per draw, the UBO is only rewritten when the extent changes
+  void setPushConstants(bool enabled);
+  static VkPushConstantRange pushConstantRange();
+
+  // meshPath names a MeshFormat file; empty draws the built-in triangle
+  void create(VkDevice device, VkPhysicalDevice physicalDevice, MemoryAllocator& allocator, UploadManager& uploads, const std::string& meshPath, uint32_t instanceCount);
+
+  // culling on this compute-only family's queue instead of the graphics queue; before create(), the uniforms are shared with it
+  void setAsyncCompute(VkQueue computeQueue, uint32_t computeFamily, uint32_t graphicsFamily);
+
+  // compute frustum culling into an indirect draw, replaces the draw list; after create()
+  void enableCulling(VkPipelineCache pipelineCache);
+
+  // async culling: submits the frame's pass after updateInstances(); the graphics submission waits on the semaphore at
+  // GpuCuller::CONSUMER_STAGES, VK_NULL_HANDLE otherwise
+  void submitCulling(uint32_t frameSlot) const;
+  VkSemaphore cullingSemaphore(uint32_t frameSlot) const;
+
+  // splits the instances into a draw list of this many instances per draw, 0 = a single draw
+  void setInstancesPerDraw(uint32_t instancesPerDraw);
+  uint32_t drawCount() const;
+
+  // vertex input of the loaded geometry, for the graphics pipeline
+  const std::vector<VkVertexInputBindingDescription>& bindingDescriptions() const;
+  const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions() const;
   
   void renderPass(
     const VkRenderPassBeginInfo &renderPassInfo, 
     const VkCommandBuffer &commandBuffer, 
     VkPipeline graphicsPipeline, 
     VkPipelineLayout pipelineLayout, 
-    const VkDescriptorSet* descriptorSet
+    const VkDescriptorSet* descriptorSet,
+    const GpuTimer& gpuTimer,
+    uint32_t frameSlot,
+    VkCommandBufferUsageFlags usage,
+    const std::vector<VkCommandBuffer>& secondaries = {} // executed instead of recording the draws inline
   );
+
+  // binds the frame's state and records draws [firstDraw, firstDraw + count) of the draw list, inside the render pass
+  void recordDraws(
+    VkCommandBuffer commandBuffer,
+    const VkRect2D& renderArea,
+    VkPipeline graphicsPipeline,
+    VkPipelineLayout pipelineLayout,
+    const VkDescriptorSet* descriptorSet,
+    uint32_t frameSlot,
+    uint32_t firstDraw,
+    uint32_t count
+  ) const;
   
-  void updateUniformBuffer(uint32_t currentImage, const VkExtent2D &swapChainExtent);
-  VkDescriptorBufferInfo descriptorBufferInfo(size_t index) const;
+  // render thread, once per frame before the updates: applies the queued input in the order it happened and
+  // takes the frame's animation time, so the rest of the frame reads a fixed snapshot without locking
+  void beginFrame(InputQueue& input);
+  void updateUniformBuffer(uint32_t frameSlot, const VkExtent2D &swapChainExtent);
+  void updateInstances(uint32_t frameSlot);
+  VkDescriptorBufferInfo descriptorBufferInfo() const;
   void cleanup();
 
-  void rotateRight();
-  void rotateLeft();
-  void rotateToggle();
-
 private:
-  uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
-  void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) const;
-  void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
-  void createVertexBuffer();
-  void createIndexBuffer();
+  void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocator::Allocation& bufferMemory);
+  void destroyBuffer(VkBuffer buffer, const MemoryAllocator::Allocation& bufferMemory);
+  void createGeometry(const std::string& meshPath);
+  void createVertexBuffer(const void* data, VkDeviceSize bufferSize);
+  void createIndexBuffer(const void* data, VkDeviceSize bufferSize);
+  void createInstanceBuffer(uint32_t instanceCount);
   void createUniformBuffers();
 
-  VkCommandBuffer beginSingleTimeCommands() const;
-  void endSingleTimeCommands(VkCommandBuffer commandBuffer) const;
-
   VkDevice m_device;
   VkPhysicalDevice m_physicalDevice;
-  VkQueue m_graphicsQueue;
-  VkCommandPool m_commandPool;
+  MemoryAllocator* m_allocator;
+  UploadManager* m_uploads;
 
   VkBuffer m_vertexBuffer;
-  VkDeviceMemory m_vertexBufferMemory;
+  MemoryAllocator::Allocation m_vertexBufferMemory;
   
   VkBuffer m_indexBuffer;
-  VkDeviceMemory m_indexBufferMemory;
-
-  std::vector<VkBuffer> m_uniformBuffers;
-  std::vector<VkDeviceMemory> m_uniformBuffersMemory;
-
-  std::unique_ptr<Timer> m_rotateTimer;
-  mutable std::mutex m_rotateTimerMutex; // mutable allows const objects to be locked
+  MemoryAllocator::Allocation m_indexBufferMemory;
+  VkIndexType m_indexType;
+  uint32_t m_indexCount;
+
+  VkBuffer m_instanceBuffer;
+  MemoryAllocator::Allocation m_instanceBufferMemory;
+  VkDeviceSize m_instanceFrameStride{ 0 }; // the buffer holds one instance stream per frame in flight
+  TransformStore m_transforms;
+  uint32_t m_instancesPerDraw{ 0 };  // 0 = all instances in one draw
+  float m_boundingRadius;            // of the mesh around its origin, in the xy plane the shaders use
+
+  GpuCuller m_culler;
+  VkQueue m_computeQueue{ VK_NULL_HANDLE }; // async culling when set
+  uint32_t m_computeFamily{ 0 };
+  uint32_t m_graphicsFamily{ 0 };
+
+  std::vector<VkVertexInputBindingDescription> m_bindingDescriptions;
+  std::vector<VkVertexInputAttributeDescription> m_attributeDescriptions;
+
+  UniformRing m_uniformRing;
+
+  bool m_pushConstants;
+  glm::mat4 m_model;                         // pushed by renderPass on the push-constant path
+  std::vector<VkExtent2D> m_uniformExtents;  // per frame slot, the extent its UBO was last written for
+
+  // animation state, only touched by the render thread
+  Timer m_rotateTimer;        // runs while rotating, started by create()
+  bool m_rotate{ true };
+  float m_spinAngle{ 45.0f }; // degrees per second of m_rotateTimer
+  float m_spinIncrement{ 1.0f };
+  float m_frameTime{ 0.0f };  // m_rotateTimer in seconds, snapshot taken by beginFrame()
 };
@@ -0,0 +1,191 @@
+// Offline converter: Wavefront OBJ -> MeshFormat container (see src/MeshFormat.hpp).
+//
+//   mesh_convert in.obj out.mesh
+//
+// Reads positions ("v x y z" with an optional "r g b" vertex colour, white otherwise) and faces
+// ("f a b c ...", with v/vt/vn references and negative indices). Polygons are triangulated as fans.
+// Texture coordinates and normals are ignored, the renderer has no use for them yet.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MeshFormat.hpp"
+
+namespace
+{
+  struct Vertex
+  {
+    float pos[3];
+    float color[3];
+  };
+
+  struct Mesh
+  {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+  };
+
+  std::runtime_error lineError(const std::string& path, size_t line, const std::string& what)
+  {
+    return std::runtime_error(path + ":" + std::to_string(line) + ": " + what);
+  }
+
+  // "7", "7/2", "7//3", "-1/2/3" -> zero based vertex index
+  uint32_t parseFaceIndex(const std::string& token, size_t vertexCount, const std::string& path, size_t line)
+  {
+    const std::string reference = token.substr(0, token.find('/'));
+
+    long index = 0;
+    size_t parsed = 0;
+    try {
+      index = std::stol(reference, &parsed);
+    }
+    catch (const std::logic_error&) { // invalid_argument, out_of_range
+      parsed = 0;
+    }
+    if (parsed == 0 || parsed != reference.size()) {
+      throw lineError(path, line, "malformed vertex index " + token);
+    }
+
+    const long resolved = index < 0 ? static_cast<long>(vertexCount) + index : index - 1;
+    if (index == 0 || resolved < 0 || resolved >= static_cast<long>(vertexCount)) {
+      throw lineError(path, line, "vertex index " + token + " out of range");
+    }
+    return static_cast<uint32_t>(resolved);
+  }
+
+  Mesh readObj(const std::string& path)
+  {
+    std::ifstream in(path);
+    if (!in) {
+      throw std::runtime_error("failed to open " + path);
+    }
+
+    Mesh mesh;
+    std::string text;
+    size_t line = 0;
+
+    while (std::getline(in, text)) {
+      ++line;
+      std::istringstream tokens(text);
+      std::string keyword;
+      tokens >> keyword;
+
+      if (keyword == "v") {
+        Vertex vertex{ { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+        if (!(tokens >> vertex.pos[0] >> vertex.pos[1] >> vertex.pos[2])) {
+          throw lineError(path, line, "malformed vertex");
+        }
+        Vertex colored = vertex;
+        if (tokens >> colored.color[0] >> colored.color[1] >> colored.color[2]) {
+          vertex = colored;
+        }
+        mesh.vertices.push_back(vertex);
+      }
+      else if (keyword == "f") {
+        std::vector<uint32_t> polygon;
+        for (std::string token; tokens >> token;) {
+          polygon.push_back(parseFaceIndex(token, mesh.vertices.size(), path, line));
+        }
+        if (polygon.size() < 3) {
+          throw lineError(path, line, "face with fewer than 3 vertices");
+        }
+        for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+          mesh.indices.insert(mesh.indices.end(), { polygon[0], polygon[i], polygon[i + 1] });
+        }
+      }
+    }
+
+    if (mesh.indices.empty()) {
+      throw std::runtime_error(path + ": no faces");
+    }
+    return mesh;
+  }
+
+  void writeBlob(std::ofstream& out, uint64_t offset, const void* data, size_t size)
+  {
+    out.seekp(static_cast<std::streamoff>(offset));
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+  }
+
+  void writeMesh(const std::string& path, const Mesh& mesh)
+  {
+    using namespace MeshFormat;
+
+    const bool shortIndices = mesh.vertices.size() <= UINT16_MAX;
+
+    // checked once here, the loader only compares maxIndex against vertexCount
+    const uint32_t maxIndex = *std::max_element(mesh.indices.begin(), mesh.indices.end());
+    if (maxIndex >= mesh.vertices.size()) {
+      throw std::runtime_error(path + ": index " + std::to_string(maxIndex) + " out of range");
+    }
+
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.headerSize = sizeof(Header);
+    header.vertexStride = sizeof(Vertex);
+    header.attributeCount = 2;
+    header.attributes[0] = { 0, AttributeFormat::Float3, offsetof(Vertex, pos), 0 };
+    header.attributes[1] = { 1, AttributeFormat::Float3, offsetof(Vertex, color), 0 };
+    header.indexSize = shortIndices ? 2 : 4;
+    header.vertexCount = mesh.vertices.size();
+    header.indexCount = mesh.indices.size();
+    header.maxIndex = maxIndex;
+    for (const Vertex& vertex : mesh.vertices) {
+      header.boundingRadius = std::max(header.boundingRadius, std::hypot(vertex.pos[0], vertex.pos[1]));
+    }
+    header.vertexOffset = alignBlob(sizeof(Header));
+    header.indexOffset = alignBlob(header.vertexOffset + header.vertexCount * header.vertexStride);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      throw std::runtime_error("failed to create " + path);
+    }
+
+    writeBlob(out, 0, &header, sizeof(header));
+    writeBlob(out, header.vertexOffset, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+
+    if (shortIndices) {
+      const std::vector<uint16_t> indices(mesh.indices.begin(), mesh.indices.end());
+      writeBlob(out, header.indexOffset, indices.data(), indices.size() * sizeof(uint16_t));
+    }
+    else {
+      writeBlob(out, header.indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+    }
+
+    if (!out) {
+      throw std::runtime_error("failed to write " + path);
+    }
+
+    std::cout << path << ": " << header.vertexCount << " vertices, " << header.indexCount << " indices ("
+      << header.indexSize * 8 << " bit)" << std::endl;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0] << " in.obj out.mesh" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try {
+    writeMesh(argv[2], readObj(argv[1]));
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+// Microbenchmark of the per-instance transform build (see src/TransformStore.h).
+//
+//   transform_bench [objects] [iterations]
+//
+// Times the scalar glm path, the SIMD kernel on one thread and the parallel build over the same objects,
+// and reports the largest difference between the scalar and SIMD matrices.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+#include "TransformStore.h"
+
+namespace
+{
+  template<typename F>
+  double nanosecondsPerObject(F&& build, size_t objects, uint32_t iterations)
+  {
+    build(); // warm up caches and wake the workers once
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+      build();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / iterations / objects;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc > 3) {
+    std::cerr << "usage: " << argv[0] << " [objects] [iterations]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const size_t objects = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  const uint32_t iterations = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 20;
+  if (objects == 0 || iterations == 0) {
+    std::cerr << "objects and iterations have to be positive" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  TransformStore transforms;
+  transforms.resize(objects);
+  for (size_t i = 0; i < objects; ++i) {
+    transforms.set(
+      i,
+      glm::vec3(0.001f * i, -0.002f * i, 0.5f),
+      0.37f * i,
+      0.25f * (i % 13) - 1.5f,
+      0.5f + 0.1f * (i % 5),
+      glm::vec4(1.0f)
+    );
+  }
+
+  std::vector<TransformStore::Instance> reference(objects);
+  std::vector<TransformStore::Instance> batched(objects);
+  const float time = 12.5f;
+
+  const double scalar = nanosecondsPerObject([&]() { transforms.buildScalar(time, reference.data(), 0, objects); }, objects, iterations);
+  const double simd = nanosecondsPerObject([&]() { transforms.buildSimd(time, batched.data(), 0, objects); }, objects, iterations);
+  const double parallel = nanosecondsPerObject([&]() { transforms.build(time, batched.data()); }, objects, iterations);
+
+  float maxError = 0.0f;
+  for (size_t i = 0; i < objects; ++i) {
+    for (int column = 0; column < 4; ++column) {
+      for (int row = 0; row < 4; ++row) {
+        maxError = std::max(maxError, std::fabs(reference[i].model[column][row] - batched[i].model[column][row]));
+      }
+    }
+  }
+
+  std::cout << objects << " objects, " << iterations << " iterations, "
+    << JobSystem::instance().workerCount() << " job workers" << std::endl
+    << std::fixed << std::setprecision(2)
+    << "scalar:   " << scalar << " ns/object" << std::endl
+    << "simd:     " << simd << " ns/object (" << scalar / simd << "x)" << std::endl
+    << "parallel: " << parallel << " ns/object (" << scalar / parallel << "x)" << std::endl
+    << std::scientific << "max difference: " << maxError << std::endl;
+
+  return EXIT_SUCCESS;
+}